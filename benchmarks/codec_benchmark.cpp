@@ -0,0 +1,124 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+*****************************************************************************/
+
+/**
+ * @file codec_benchmark.cpp
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Compression ratio and throughput of the frame codecs in codec.h.
+ *
+ * Usage: codec_benchmark [frames.bin values_per_frame]
+ *
+ * frames.bin holds consecutive frames of raw native doubles, for example
+ * the values of one attribute dumped at every commit of a coupled run.
+ * Without arguments a synthetic travelling wave is used.
+ *
+ * Build: g++ -std=c++11 -O2 -I../src [-DMUI_USE_ZLIB ... -lz] codec_benchmark.cpp
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include "general/util.h"
+#include "storage/dynstorage.h"
+#include "communication/message/codec.h"
+
+using storage_t = mui::storage<std::vector<double> >;
+
+static std::vector<std::vector<double> > load_frames( const char* path, std::size_t n ) {
+	std::vector<std::vector<double> > frames;
+	std::ifstream in(path, std::ios::binary);
+	std::vector<double> f(n);
+	while( in.read(reinterpret_cast<char*>(f.data()), n*sizeof(double)) ) frames.push_back(f);
+	return frames;
+}
+
+static std::vector<std::vector<double> > synthetic_frames( std::size_t n, std::size_t count ) {
+	std::vector<std::vector<double> > frames(count, std::vector<double>(n));
+	for( std::size_t t=0; t<count; ++t )
+		for( std::size_t i=0; i<n; ++i ) {
+			const double x = static_cast<double>(i)/static_cast<double>(n);
+			frames[t][i] = std::sin(6.283185307179586*(4*x - 0.002*t)) + 0.5*x*x;
+		}
+	return frames;
+}
+
+int main( int argc, char** argv ) {
+	const std::vector<std::vector<double> > frames = argc > 2 ? load_frames(argv[1], std::stoul(argv[2]))
+	                                                          : synthetic_frames(1u<<18, 32);
+	if( frames.empty() ) {
+		std::printf("No frames read.\n");
+		return 1;
+	}
+
+	struct named_config { const char* name; mui::codec_config config; };
+	const named_config configs[] = {
+		{ "none",                 mui::codec_config(false, false, mui::codec_compression::none) },
+		{ "rle",                  mui::codec_config(false, false, mui::codec_compression::rle) },
+		{ "shuffle+rle",          mui::codec_config(false, true,  mui::codec_compression::rle) },
+		{ "delta+shuffle+rle",    mui::codec_config(true,  true,  mui::codec_compression::rle) },
+		{ "delta+shuffle+zlib",   mui::codec_config(true,  true,  mui::codec_compression::zlib) },
+		{ "quantise(1e-6)+delta", mui::codec_config(true,  true,  mui::codec_compression::rle, 1e-6) },
+		{ "quantise(1e-3)+delta", mui::codec_config(true,  true,  mui::codec_compression::rle, 1e-3) }
+	};
+
+	std::printf("%zu frames of %zu values\n", frames.size(), frames[0].size());
+	std::printf("%-22s %8s %12s %12s %12s\n", "codec", "ratio", "enc MB/s", "dec MB/s", "max error");
+	for( const named_config& c: configs ) {
+		mui::codec::state encoder, decoder;
+		double raw = 0, packed = 0, enc_time = 0, dec_time = 0, max_err = 0;
+		for( const std::vector<double>& f: frames ) {
+			const storage_t st{std::vector<double>(f)};
+			auto t0 = std::chrono::steady_clock::now();
+			const mui::codec_block b = encoder.encode("u", st, c.config);
+			auto t1 = std::chrono::steady_clock::now();
+			storage_t out = decoder.decode<storage_t>("u", b);
+			auto t2 = std::chrono::steady_clock::now();
+
+			enc_time += std::chrono::duration<double>(t1-t0).count();
+			dec_time += std::chrono::duration<double>(t2-t1).count();
+			raw += static_cast<double>(b.raw_size);
+			packed += static_cast<double>(mui::streamed_size(b));
+			const std::vector<double>& v = mui::storage_cast<const std::vector<double>&>(out);
+			for( std::size_t i=0; i<f.size(); ++i ) max_err = std::max(max_err, std::abs(v[i]-f[i]));
+		}
+		std::printf("%-22s %8.2f %12.1f %12.1f %12.3g\n", c.name, raw/packed, raw/enc_time*1e-6, raw/dec_time*1e-6, max_err);
+	}
+	return 0;
+}
@@ -0,0 +1,420 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+*****************************************************************************/
+
+/**
+ * @file mui_benchmarks.cpp
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Google Benchmark suite of the coupling path: push, commit, commit
+ * followed by barrier, message transfer, bin build, fetch with every spatial
+ * and temporal sampler, and RBF build and apply.
+ *
+ * Usage: mui_benchmarks [--benchmark_filter=regex] [--benchmark_out=file.json]
+ *        mpirun -np 2 mui_benchmarks [...]
+ *
+ * Point clouds are uniform, or graded towards x = 0 like a boundary layer,
+ * in the unit cube, from 10^3 points up to MUI_BENCH_MAX_POINTS (default 10^6,
+ * set 10000000 for the full range). Message transfer runs over inproc in one
+ * process; with two ranks it also runs between them over mpi, shm, tcp and,
+ * with USE_IO_URING, tcp+uring. --benchmark_out writes JSON (--benchmark_out_format=csv for CSV)
+ * for tracking results across releases.
+ *
+ * Build: cmake -DBUILD_BENCHMARKS=ON, or
+ *        mpicxx -std=c++11 -O2 -I../src mui_benchmarks.cpp -lbenchmark -lpthread
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <benchmark/benchmark.h>
+#include "mui.h"
+
+namespace {
+
+struct config : mui::config_3d {
+	static const bool QUIET = true;
+};
+using REAL = config::REAL;
+using point_type = config::point_type;
+using uniface_t = mui::uniface<config>;
+
+const std::size_t QUERIES = 1000; // fetches per iteration
+const std::size_t RBF_MAX_POINTS = 10000;
+const int FRAMES = 5;
+
+enum class cloud { uniform, graded };
+const cloud CLOUDS[] = { cloud::uniform, cloud::graded };
+
+const char* cloud_name( cloud c ) {
+	return c == cloud::uniform ? "uniform" : "graded";
+}
+
+std::vector<point_type> make_cloud( cloud c, std::size_t n ) {
+	std::mt19937_64 gen(12345);
+	std::uniform_real_distribution<REAL> u(0, 1);
+	std::vector<point_type> pts(n);
+	for( auto& p: pts ) {
+		for( int d = 0; d < config::D; ++d ) p[d] = u(gen);
+		if( c == cloud::graded ) p[0] = p[0]*p[0]*p[0];
+	}
+	return pts;
+}
+
+REAL value_at( const point_type& p ) {
+	return std::sin(4*p[0]) + p[1]*p[2];
+}
+
+// mean spacing of n uniform points; graded clouds are up to three times coarser
+REAL spacing( std::size_t n ) {
+	return std::pow(REAL(n), REAL(-1)/config::D);
+}
+
+// unique interface names, so that inproc pairs never meet twice
+std::string next_path( const char* what ) {
+	static int count = 0;
+	return std::string(what) + std::to_string(count++);
+}
+
+/* sink_comm
+ * One remote rank that takes every message, serialised, and never answers.
+ */
+class sink_comm: public mui::communicator {
+protected:
+	void send_impl_( mui::message msg, const std::vector<bool>& ) {
+		benchmark::DoNotOptimize(msg.detach().data());
+	}
+	mui::message recv_impl_() {
+		return mui::message();
+	}
+};
+
+/* inproc_pair
+ * Sending side a and receiving side b of one inproc interface.
+ */
+struct inproc_pair {
+	explicit inproc_pair( const std::string& path ) :
+		a(new uniface_t("inproc://a/" + path)), b(new uniface_t("inproc://b/" + path)) {}
+	std::unique_ptr<uniface_t> a;
+	std::unique_ptr<uniface_t> b;
+};
+
+struct field {
+	field( cloud c, std::size_t n ) : pts(make_cloud(c, n)), vals(n) {
+		for( std::size_t i = 0; i < n; ++i ) vals[i] = value_at(pts[i]);
+	}
+	void push( uniface_t& ifs, REAL scale = 1 ) const {
+		for( std::size_t i = 0; i < pts.size(); ++i ) ifs.push("u", pts[i], scale*vals[i]);
+	}
+	std::vector<point_type> pts;
+	std::vector<REAL> vals;
+};
+
+void bm_push( benchmark::State& state, cloud c ) {
+	const field f(c, state.range(0));
+	uniface_t ifs(new sink_comm);
+	REAL t = 0;
+	for( auto _: state ) {
+		f.push(ifs);
+		state.PauseTiming();
+		ifs.commit(++t);
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+
+void bm_commit( benchmark::State& state, cloud c ) {
+	const field f(c, state.range(0));
+	uniface_t ifs(new sink_comm);
+	REAL t = 0;
+	for( auto _: state ) {
+		state.PauseTiming();
+		f.push(ifs);
+		state.ResumeTiming();
+		ifs.commit(++t);
+	}
+	state.SetBytesProcessed(state.iterations()*state.range(0)*(sizeof(point_type)+sizeof(REAL)));
+}
+
+void bm_commit_barrier( benchmark::State& state, cloud c ) {
+	const field f(c, state.range(0));
+	inproc_pair ifs(next_path("barrier"));
+	REAL t = 0;
+	for( auto _: state ) {
+		state.PauseTiming();
+		f.push(*ifs.a);
+		state.ResumeTiming();
+		ifs.a->commit(++t);
+		ifs.b->barrier(t);
+		state.PauseTiming();
+		ifs.b->forget(t);
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+
+void bm_bin_build( benchmark::State& state, cloud c ) {
+	const std::vector<point_type> pts = make_cloud(c, state.range(0));
+	for( auto _: state ) {
+		state.PauseTiming();
+		std::vector<point_type> p(pts);
+		std::vector<std::size_t> perm;
+		state.ResumeTiming();
+		mui::bin_t<config> bin(p, perm);
+		benchmark::DoNotOptimize(perm.data());
+	}
+	state.SetItemsProcessed(state.iterations()*state.range(0));
+}
+
+void bm_transfer( benchmark::State& state, mui::communicator* comm ) {
+	const std::vector<char> payload(state.range(0));
+	for( auto _: state ) {
+		comm->send(mui::message::make("ping", payload));
+		mui::message back = comm->recv();
+		benchmark::DoNotOptimize(back.data());
+	}
+	state.SetBytesProcessed(2*state.iterations()*state.range(0));
+}
+
+/* fetch_data
+ * Frames at t = 1 to 5 of one cloud, received and binned, and the points to
+ * fetch at. Fetches are at t = 2, or 2.5 between frames for the interpolating
+ * temporal samplers, so that the temporal windows are complete.
+ * Kept between runs of the same cloud and size.
+ */
+struct fetch_data {
+	fetch_data( cloud c, std::size_t n ) : ifs(next_path("fetch")) {
+		const field f(c, n);
+		for( int t = 1; t <= FRAMES; ++t ) {
+			f.push(*ifs.a, REAL(t));
+			ifs.a->commit(REAL(t));
+		}
+		mui::temporal_sampler_exact<config> exact;
+		for( int t = 1; t <= FRAMES; ++t ) ifs.b->fetch_points<REAL>("u", REAL(t), exact);
+
+		const std::size_t stride = std::max<std::size_t>(1, n/QUERIES);
+		for( std::size_t i = 0; i < n && queries.size() < QUERIES; i += stride ) queries.push_back(f.pts[i]);
+	}
+	inproc_pair ifs;
+	std::vector<point_type> queries;
+};
+
+fetch_data& fetch_data_for( cloud c, std::size_t n ) {
+	static std::unique_ptr<fetch_data> data;
+	static std::pair<cloud, std::size_t> key;
+	if( !data || key != std::make_pair(c, n) ) {
+		data.reset();
+		data.reset(new fetch_data(c, n));
+		key = std::make_pair(c, n);
+	}
+	return *data;
+}
+
+template<class SAMPLER, class TIME_SAMPLER>
+void run_fetch( benchmark::State& state, fetch_data& d, SAMPLER& s, const TIME_SAMPLER& ts, REAL t = REAL(2) ) {
+	for( auto _: state ) {
+		REAL sum = 0;
+		for( const point_type& q: d.queries ) sum += d.ifs.b->fetch("u", q, t, s, ts);
+		benchmark::DoNotOptimize(sum);
+	}
+	state.SetItemsProcessed(state.iterations()*d.queries.size());
+}
+
+std::vector<int64_t> point_counts( std::size_t max ) {
+	std::size_t limit = 1000000;
+	if( const char* v = std::getenv("MUI_BENCH_MAX_POINTS") ) limit = std::strtoull(v, nullptr, 10);
+	std::vector<int64_t> n;
+	for( std::size_t i = 1000; i <= std::min(limit, max); i *= 10 ) n.push_back(i);
+	return n;
+}
+
+benchmark::internal::Benchmark* sized( benchmark::internal::Benchmark* b, std::size_t max = std::size_t(-1) ) {
+	for( int64_t n: point_counts(max) ) b->Arg(n);
+	return b->Unit(benchmark::kMicrosecond);
+}
+
+// spatial sampler made by make(h) for spacing h, with exact time
+template<class MAKE>
+void register_spatial( const std::string& name, MAKE make ) {
+	for( cloud c: CLOUDS )
+		sized(benchmark::RegisterBenchmark(("fetch/" + name + "/" + cloud_name(c)).c_str(), [c, make]( benchmark::State& state ) {
+			fetch_data& d = fetch_data_for(c, state.range(0));
+			auto s = make(spacing(state.range(0)));
+			run_fetch(state, d, s, mui::temporal_sampler_exact<config>());
+		}));
+}
+
+// temporal sampler over the frames around t, with exact space
+template<class TIME_SAMPLER>
+void register_temporal( const std::string& name, TIME_SAMPLER ts, REAL t = REAL(2) ) {
+	for( cloud c: CLOUDS )
+		sized(benchmark::RegisterBenchmark(("fetch_temporal/" + name + "/" + cloud_name(c)).c_str(), [c, ts, t]( benchmark::State& state ) {
+			fetch_data& d = fetch_data_for(c, state.range(0));
+			mui::sampler_exact<config, REAL, REAL> s;
+			run_fetch(state, d, s, ts, t);
+		}));
+}
+
+void register_rbf() {
+	using rbf_t = mui::sampler_rbf<config, REAL, REAL>;
+	for( cloud c: CLOUDS ) {
+		// matrix construction, timed with the first fetch that triggers it
+		sized(benchmark::RegisterBenchmark((std::string("rbf_build/") + cloud_name(c)).c_str(), [c]( benchmark::State& state ) {
+			fetch_data& d = fetch_data_for(c, state.range(0));
+			mui::temporal_sampler_exact<config> ts;
+			for( auto _: state ) {
+				rbf_t rbf(4*spacing(state.range(0)), d.queries);
+				benchmark::DoNotOptimize(d.ifs.b->fetch("u", d.queries[0], REAL(2), rbf, ts));
+			}
+		}), RBF_MAX_POINTS);
+		sized(benchmark::RegisterBenchmark((std::string("rbf_apply/") + cloud_name(c)).c_str(), [c]( benchmark::State& state ) {
+			fetch_data& d = fetch_data_for(c, state.range(0));
+			mui::temporal_sampler_exact<config> ts;
+			rbf_t rbf(4*spacing(state.range(0)), d.queries);
+			d.ifs.b->fetch("u", d.queries[0], REAL(2), rbf, ts);
+			run_fetch(state, d, rbf, ts);
+		}), RBF_MAX_POINTS);
+	}
+}
+
+void register_all( const std::vector<std::pair<std::string, mui::communicator*> >& links ) {
+	for( cloud c: CLOUDS ) {
+		const std::string n = cloud_name(c);
+		sized(benchmark::RegisterBenchmark(("push/" + n).c_str(), bm_push, c));
+		sized(benchmark::RegisterBenchmark(("commit/" + n).c_str(), bm_commit, c));
+		sized(benchmark::RegisterBenchmark(("commit_barrier/inproc/" + n).c_str(), bm_commit_barrier, c));
+		sized(benchmark::RegisterBenchmark(("bin_build/" + n).c_str(), bm_bin_build, c));
+	}
+
+	for( auto& l: links )
+		benchmark::RegisterBenchmark(("transfer/" + l.first).c_str(), bm_transfer, l.second)
+			->RangeMultiplier(8)->Range(64, 16 << 20)->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+	// support radii cover the coarse side of the graded clouds
+	register_spatial("exact", []( REAL ) { return mui::sampler_exact<config, REAL, REAL>(); });
+	register_spatial("gauss", []( REAL h ) { return mui::sampler_gauss<config, REAL, REAL>(4*h, h); });
+	register_spatial("moving_average", []( REAL h ) { return mui::sampler_moving_average<config, REAL, REAL>(point_type(4*h)); });
+	register_spatial("nearest_neighbor", []( REAL ) { return mui::sampler_nearest_neighbor<config, REAL, REAL>(); });
+	register_spatial("pseudo_nearest_neighbor", []( REAL h ) { return mui::sampler_pseudo_nearest_neighbor<config, REAL, REAL>(4*h); });
+	register_spatial("pseudo_n2_linear", []( REAL h ) { return mui::sampler_pseudo_n2_linear<config, REAL, REAL>(4*h); });
+	register_spatial("shepard_quintic", []( REAL h ) { return mui::sampler_shepard_quintic<config, REAL, REAL>(4*h); });
+	register_spatial("sph_quintic", []( REAL h ) { return mui::sampler_sph_quintic<config, REAL, REAL>(4*h); });
+	register_spatial("sum_quintic", []( REAL h ) { return mui::sampler_sum_quintic<config, REAL, REAL>(4*h); });
+
+	register_temporal("exact", mui::temporal_sampler_exact<config>());
+	register_temporal("gauss", mui::temporal_sampler_gauss<config>(REAL(1.5), REAL(0.5)));
+	register_temporal("mean", mui::temporal_sampler_mean<config>(REAL(1), REAL(1)));
+	register_temporal("sum", mui::temporal_sampler_sum<config>(REAL(1), REAL(1)));
+	// interpolating samplers fetch between two frames
+	register_temporal("linear", mui::temporal_sampler_linear<config>(REAL(1)), REAL(2.5));
+	register_temporal("hermite", mui::temporal_sampler_hermite<config>(REAL(3)), REAL(2.5));
+	register_temporal("lagrange", mui::temporal_sampler_lagrange<config>(REAL(3)), REAL(2.5));
+
+	register_rbf();
+}
+
+// returns every message to its sender until "stop"
+void echo( mui::communicator* comm ) {
+	for(;;) {
+		mui::message msg = comm->recv();
+		if( msg.id() == "stop" ) return;
+		comm->send(std::move(msg));
+	}
+}
+
+}
+
+int main( int argc, char** argv ) {
+	int provided;
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_MULTIPLE, &provided);
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	if( size > 2 ) {
+		if( rank == 0 ) std::fprintf(stderr, "run with 1 or 2 ranks\n");
+		MPI_Finalize();
+		return 1;
+	}
+	benchmark::Initialize(&argc, argv);
+
+	// each side is a single rank of its own tcp domain
+	setenv("MUI_TCP_RANK", "0", 1);
+	setenv("MUI_TCP_SIZE", "1", 1);
+
+	// near ends on rank 0, far ends echo on rank 1 or on a thread
+	std::vector<std::unique_ptr<mui::communicator> > near, far;
+	std::vector<std::pair<std::string, mui::communicator*> > links;
+	if( rank == 0 ) {
+		near.emplace_back(mui::comm_factory::create_comm("inproc://near/transfer", true));
+		far.emplace_back(mui::comm_factory::create_comm("inproc://far/transfer", true));
+		links.emplace_back("inproc", near.back().get());
+	}
+	if( size == 2 ) {
+		const char* protocols[][2] = { {"mpi", "transfer_mpi"}, {"shm", "transfer_shm"},
+		                               {"tcp", "transfer_tcp"},
+#ifdef MUI_IO_URING
+		                               {"tcp+uring", "transfer_uring"}
+#endif
+		                             };
+		for( auto& p: protocols ) {
+			const std::string uri = std::string(p[0]) + "://" + (rank == 0 ? "near" : "far") + "/" + p[1];
+			(rank == 0 ? near : far).emplace_back(mui::comm_factory::create_comm(uri.c_str(), true));
+			if( rank == 0 ) links.emplace_back(p[0], near.back().get());
+		}
+	}
+
+	std::vector<std::thread> echoes;
+	for( auto& f: far ) echoes.emplace_back(echo, f.get());
+
+	if( rank == 0 ) {
+		benchmark::AddCustomContext("mui_ranks", std::to_string(size));
+		register_all(links);
+		benchmark::RunSpecifiedBenchmarks();
+		for( auto& n: near ) n->send(mui::message::make("stop"));
+	}
+
+	for( auto& e: echoes ) e.join();
+	near.clear();
+	far.clear();
+	benchmark::Shutdown();
+	MPI_Finalize();
+	return 0;
+}
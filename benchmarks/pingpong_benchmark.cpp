@@ -0,0 +1,129 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+*****************************************************************************/
+
+/**
+ * @file pingpong_benchmark.cpp
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Ping-pong latency of the communicators, message sizes from 8 B to 256 KiB.
+ *
+ * Usage: mpirun -np 2 pingpong_benchmark [protocol ...]
+ *
+ * Protocols default to "mpi shm tcp", plus "tcp+uring" when built with
+ * -DMUI_IO_URING. Rank 0 and rank 1 form the two
+ * domains. Set MUI_TCP_BUSY_POLL (microseconds) to measure tcp with
+ * busy polling, and MUI_SHM_SPIN at compile time for shm.
+ *
+ * Build: mpicxx -std=c++11 -O2 -I../src pingpong_benchmark.cpp
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "mui.h"
+
+static void pingpong( const std::string& protocol, int rank ) {
+	using clock = std::chrono::steady_clock;
+	const std::string uri = protocol + "://" + (rank == 0 ? "ping" : "pong") + "/pingpong";
+	std::unique_ptr<mui::communicator> comm(mui::comm_factory::create_comm(uri.c_str(), true));
+
+	if( rank == 0 ) std::printf("%-6s %10s %12s %12s %12s\n", "proto", "bytes", "median(us)", "p99(us)", "MB/s");
+
+	for( std::size_t size = 8; size <= (std::size_t(1) << 18); size *= 8 ) {
+		const int iters = size <= 4096 ? 2000 : 200;
+		const int warmup = iters/10;
+		std::vector<double> oneway;
+		oneway.reserve(iters);
+
+		for( int i = 0; i < warmup + iters; ++i ) {
+			if( rank == 0 ) {
+				auto start = clock::now();
+				comm->send(mui::message::make("ping", std::vector<char>(size)));
+				comm->recv();
+				double us = std::chrono::duration<double, std::micro>(clock::now() - start).count();
+				if( i >= warmup ) oneway.push_back(us/2);
+			}
+			else {
+				comm->recv();
+				comm->send(mui::message::make("pong", std::vector<char>(size)));
+			}
+		}
+
+		if( rank == 0 ) {
+			std::sort(oneway.begin(), oneway.end());
+			const double median = oneway[oneway.size()/2];
+			const double p99 = oneway[oneway.size()*99/100];
+			std::printf("%-6s %10zu %12.2f %12.2f %12.1f\n", protocol.c_str(), size, median, p99, size/median);
+		}
+	}
+}
+
+int main( int argc, char** argv ) {
+	MPI_Init(&argc, &argv);
+	int rank, size;
+	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+	MPI_Comm_size(MPI_COMM_WORLD, &size);
+	if( size != 2 ) {
+		if( rank == 0 ) std::fprintf(stderr, "run with exactly 2 ranks\n");
+		MPI_Finalize();
+		return 1;
+	}
+
+	// each side is a single rank of its own tcp domain
+	setenv("MUI_TCP_RANK", "0", 1);
+	setenv("MUI_TCP_SIZE", "1", 1);
+
+	std::vector<std::string> protocols;
+	for( int i = 1; i < argc; ++i ) protocols.push_back(argv[i]);
+	if( protocols.empty() ) {
+		protocols = {"mpi", "shm", "tcp"};
+#ifdef MUI_IO_URING
+		protocols.push_back("tcp+uring");
+#endif
+	}
+
+	for( auto& p: protocols ) {
+		pingpong(p, rank);
+		MPI_Barrier(MPI_COMM_WORLD);
+	}
+
+	MPI_Finalize();
+	return 0;
+}
@@ -48,8 +48,10 @@
 #ifndef COMM_H_
 #define COMM_H_
 
+#include <stdexcept>
 #include <vector>
 #include "message/message.h"
+#include "../general/metrics.h"
 
 namespace mui {
 class communicator {
@@ -67,31 +69,93 @@ public:
 	virtual std::string uri_host() const { return std::string(); }
 	virtual std::string uri_path() const { return std::string(); }
 	virtual std::string uri_protocol() const { return std::string(); }
+	// true if send() may be called from one thread while another calls recv()
+	virtual bool concurrent_send() const { return false; }
+	// true if messages reach the peer as objects, so they need not be serialised
+	virtual bool in_process() const { return false; }
+	// true if exchange() is available
+	virtual bool collective() const { return false; }
+	// true if recv() would return a message without blocking; false when unknown
+	virtual bool ready() { return false; }
+
+	// sends msg to every remote rank and returns the message of each, indexed by remote rank;
+	// every rank of both domains must take part
+	std::vector<message> exchange( message msg ) {
+		count_sent_(msg, std::vector<bool>(remote_size(), true));
+		std::vector<message> from = exchange_impl_(std::move(msg));
+#ifdef MUI_METRICS
+		if( metrics_ )
+			for( std::size_t i = 0; i < from.size(); ++i ) {
+				metrics_->received(int(i), streamed_size(from[i].id()) + from[i].size());
+				metrics_->message_received(from[i].id());
+			}
+#endif
+		return from;
+	}
+
+	// counters of messages and bytes go to m from now on, nullptr stops counting
+	void set_metrics( metrics* m ) { metrics_ = m; }
 
 	// send message
 	void send( message msg, const std::vector<bool> &is_sending ) {
-		if( is_sending.size() == static_cast<size_t>(remote_size()) )
+		if( is_sending.size() == static_cast<size_t>(remote_size()) ) {
+			count_sent_(msg, is_sending);
 			return send_impl_(std::move(msg), is_sending);
+		}
 		else {
 			std::vector<bool> dest = is_sending;
 			dest.resize(remote_size(), true);
+			count_sent_(msg, dest);
 			return send_impl_(std::move(msg), dest);
 		}
 	}
 	void send( message msg ) {
 		std::vector<bool> is_sending(remote_size(),true);
+		count_sent_(msg, is_sending);
 		return send_impl_(std::move(msg),is_sending);
 	}
 
 	// recv messages
 	message recv() {
-		return recv_impl_();
+		message msg = recv_impl_();
+#ifdef MUI_METRICS
+		if( metrics_ ) metrics_->message_received(msg.id());
+#endif
+		return msg;
 	}
 
 
 protected:
 	virtual void send_impl_( message msg, const std::vector<bool> &is_sending ) = 0;
 	virtual message recv_impl_() = 0;
+	virtual std::vector<message> exchange_impl_( message ) {
+		throw std::logic_error("MUI Error [comm.h]: Communicator has no collective exchange");
+	}
+
+	// implementations report the bytes of each message read from remote rank peer
+	void count_received_( int peer, std::size_t bytes ) {
+#ifdef MUI_METRICS
+		if( metrics_ ) metrics_->received(peer, bytes);
+#else
+		(void) peer; (void) bytes;
+#endif
+	}
+
+private:
+	void count_sent_( const message& msg, const std::vector<bool> &is_sending ) {
+#ifdef MUI_METRICS
+		if( !metrics_ ) return;
+		metrics_->message_sent(msg.id());
+		// in-process messages are never serialised, so they count as empty
+		const std::size_t bytes = in_process() ? 0 : streamed_size(msg.id()) + msg.size();
+		for( std::size_t i = 0; i < is_sending.size(); ++i )
+			if( is_sending[i] ) metrics_->sent(int(i), bytes);
+#else
+		(void) msg; (void) is_sending;
+#endif
+	}
+
+	metrics* metrics_ = nullptr;
 };
 }
 
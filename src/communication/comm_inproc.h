@@ -0,0 +1,221 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+******************************************************************************/
+
+/**
+ * @file comm_inproc.h
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Communicator between two interfaces of the same process, selected
+ * with "inproc://domain/interface".
+ *
+ * Both sides of an interface must live in one executable, for example two
+ * solvers linked together or a test driving both ends. Messages are passed
+ * as objects through a lock-free queue: uniface builds them with
+ * message::make_lazy, so frames are never serialised and their storage is
+ * moved straight into the peer's log. Neither side needs MPI, and the first
+ * side to arrive does not wait for the second.
+ */
+
+#ifndef COMM_INPROC_H
+#define COMM_INPROC_H
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include "comm.h"
+#include "comm_factory.h"
+#include "lib_uri.h"
+
+namespace mui {
+
+/* inproc_queue
+ * Unbounded multi-producer, single-consumer queue of messages (Vyukov's
+ * intrusive list). The consumer only sleeps when the queue is empty.
+ */
+class inproc_queue {
+	struct node_ {
+		std::atomic<node_*> next;
+		message msg;
+	};
+public:
+	inproc_queue(): head_(new node_()), tail_(head_.load()), sleeping_(false) {
+		tail_->next.store(nullptr);
+	}
+	~inproc_queue() {
+		while( tail_ ) {
+			node_* next = tail_->next.load();
+			delete tail_;
+			tail_ = next;
+		}
+	}
+
+	void push( message msg ) {
+		node_* n = new node_();
+		n->next.store(nullptr, std::memory_order_relaxed);
+		n->msg = std::move(msg);
+		node_* prev = head_.exchange(n, std::memory_order_acq_rel);
+		prev->next.store(n);
+		if( sleeping_.load() ) {
+			std::lock_guard<std::mutex> lock(mutex_);
+			cv_.notify_one();
+		}
+	}
+	// only the consumer may ask
+	bool ready() const {
+		return tail_->next.load(std::memory_order_acquire) != nullptr;
+	}
+	message pop() {
+		node_* next = tail_->next.load(std::memory_order_acquire);
+		if( !next ) {
+			sleeping_.store(true);
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [&]() { return (next = tail_->next.load()) != nullptr; });
+			sleeping_.store(false);
+		}
+		// next becomes the new dummy node once its message is taken
+		message msg = std::move(next->msg);
+		delete tail_;
+		tail_ = next;
+		return msg;
+	}
+private:
+	std::atomic<node_*> head_;
+	node_* tail_;
+	std::atomic_bool sleeping_;
+	std::mutex mutex_;
+	std::condition_variable cv_;
+};
+
+/* inproc_channel
+ * The two sides of one interface, each with the queue it receives from.
+ */
+struct inproc_channel {
+	std::string domain[2];
+	bool attached[2] = {false, false};
+	inproc_queue inbox[2];
+};
+
+class comm_inproc: public communicator {
+public:
+	comm_inproc( const char URI[], const bool quiet ) {
+		uri desc(URI);
+		uri_host_ = desc.host();
+		uri_path_ = desc.path();
+		uri_protocol_ = desc.protocol();
+
+		// find the channel of the interface and take the side of this domain
+		std::lock_guard<std::mutex> lock(registry_mutex_());
+		auto& registry = registry_();
+		std::shared_ptr<inproc_channel>& entry = registry[uri_path_];
+		if( !entry ) entry = std::make_shared<inproc_channel>();
+		channel_ = entry;
+		side_ = -1;
+		for( int i = 0; i < 2 && side_ < 0; ++i )
+			if( channel_->domain[i] == uri_host_ ) side_ = i;
+		for( int i = 0; i < 2 && side_ < 0; ++i )
+			if( channel_->domain[i].empty() ) side_ = i;
+		if( side_ < 0 )
+			throw std::runtime_error("MUI Error [comm_inproc.h]: Interface " + uri_path_ + " already joins two other domains");
+		if( channel_->attached[side_] )
+			throw std::runtime_error("MUI Error [comm_inproc.h]: " + std::string(URI) + " is already in use");
+		channel_->domain[side_] = uri_host_;
+		channel_->attached[side_] = true;
+
+		// like the other communicators, rank 0 of every domain reports even when quiet
+		(void) quiet;
+		std::cout << "MUI [comm_inproc.h]: Identifier: " << URI << ", Domain size: 1, Peers: 1" << std::endl;
+	}
+	~comm_inproc() {
+		std::lock_guard<std::mutex> lock(registry_mutex_());
+		channel_->attached[side_] = false;
+		// the channel, and any messages in it, outlives a side that leaves before its peer joins
+		bool done = true;
+		for( int i = 0; i < 2; ++i )
+			done = done && !channel_->domain[i].empty() && !channel_->attached[i];
+		auto itr = registry_().find(uri_path_);
+		if( done && itr != registry_().end() && itr->second == channel_ ) registry_().erase(itr);
+	}
+
+	int local_rank() const { return 0; }
+	int local_size() const { return 1; }
+	int remote_size() const { return 1; }
+	std::string uri_host() const { return uri_host_; }
+	std::string uri_path() const { return uri_path_; }
+	std::string uri_protocol() const { return uri_protocol_; }
+	bool concurrent_send() const { return true; }
+	bool in_process() const { return true; }
+	bool ready() { return channel_->inbox[side_].ready(); }
+
+protected:
+	void send_impl_( message msg, const std::vector<bool>& is_sending ) {
+		if( is_sending[0] ) channel_->inbox[1-side_].push(std::move(msg));
+	}
+	message recv_impl_() {
+		message msg = channel_->inbox[side_].pop();
+		count_received_(0, 0); // never serialised, see in_process()
+		return msg;
+	}
+
+private:
+	static std::map<std::string, std::shared_ptr<inproc_channel> >& registry_() {
+		static std::map<std::string, std::shared_ptr<inproc_channel> > registry;
+		return registry;
+	}
+	static std::mutex& registry_mutex_() {
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	std::string uri_host_;
+	std::string uri_path_;
+	std::string uri_protocol_;
+	std::shared_ptr<inproc_channel> channel_;
+	int side_;
+};
+
+inline communicator* create_comm_inproc( const char URI[], const bool quiet ) {
+	return static_cast<communicator*>(new comm_inproc(URI, quiet));
+}
+
+const static bool comm_inproc_registered_ = comm_factory::instance().link( "inproc", create_comm_inproc );
+
+}
+
+#endif
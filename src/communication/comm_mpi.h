@@ -48,6 +48,7 @@
 #define COMM_MPI_H_
 
 #include <mpi.h>
+#include <limits>
 #include "comm.h"
 #include "../general/util.h"
 #include "lib_uri.h"
@@ -168,7 +169,36 @@ public:
 	virtual std::string uri_path() const { return uri_path_; }
 	virtual std::string uri_protocol() const { return uri_protocol_; }
 
+	virtual bool collective() const { return true; }
+
 protected:
+	// one MPI_Allgatherv over the intercommunicator: each rank contributes msg once and
+	// receives the contribution of every remote rank
+	virtual std::vector<message> exchange_impl_( message msg ) {
+		std::vector<char> bytes = msg.detach();
+		if( bytes.size() > static_cast<std::size_t>(std::numeric_limits<int>::max()) )
+			throw std::range_error("MUI Error [comm_mpi.h]: Exchanged message too large");
+		int size = static_cast<int>(bytes.size());
+
+		std::vector<int> sizes(remote_size_), displs(remote_size_);
+		MPI_Allgather(&size, 1, MPI_INT, sizes.data(), 1, MPI_INT, domain_remote_);
+		long long total = 0;
+		for( int i = 0; i < remote_size_; ++i ) {
+			displs[i] = static_cast<int>(total);
+			total += sizes[i];
+			if( total > std::numeric_limits<int>::max() )
+				throw std::range_error("MUI Error [comm_mpi.h]: Exchanged messages too large");
+		}
+		std::vector<char> all(total);
+		MPI_Allgatherv(bytes.data(), size, MPI_BYTE, all.data(), sizes.data(), displs.data(), MPI_BYTE, domain_remote_);
+
+		std::vector<message> from;
+		from.reserve(remote_size_);
+		for( int i = 0; i < remote_size_; ++i )
+			from.emplace_back(message::make(std::vector<char>(all.begin()+displs[i], all.begin()+displs[i]+sizes[i])));
+		return from;
+	}
+
 	MPI_Comm domain_local_;
 	MPI_Comm domain_remote_;
 	int local_size_;
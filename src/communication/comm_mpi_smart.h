@@ -57,12 +57,14 @@
 #include "message/message.h"
 #include "../storage/stream.h"
 #include <condition_variable>
+#include <mutex>
 
 namespace mui {
 
 class comm_mpi_smart : public comm_mpi {
 private:
 	std::list<std::pair<MPI_Request,std::shared_ptr<std::vector<char> > > > send_buf;
+	std::mutex send_mutex_; // guards send_buf
 	std::mutex recv_mutex_;
 	std::condition_variable recv_cv_;
 	std::list<message> mesgs_;
@@ -73,26 +75,43 @@ public:
 		test_completion_blocking();
 	}
 
+	/** \brief MPI may be entered from several threads at once only with MPI_THREAD_MULTIPLE
+	 */
+	bool concurrent_send() const {
+		int provided = MPI_THREAD_SINGLE;
+		MPI_Query_thread(&provided);
+		return provided == MPI_THREAD_MULTIPLE;
+	}
+
+	/** \brief A message from any remote rank has arrived
+	 */
+	bool ready() {
+		int flag = 0;
+		MPI_Iprobe(MPI_ANY_SOURCE, 0, domain_remote_, &flag, MPI_STATUS_IGNORE);
+		return flag != 0;
+	}
+
 private:
 	void send_impl_( message msg, const std::vector<bool> &is_sending ) {
-	  auto bytes = std::vector<char>(msg.detach());
+		// One buffer is shared by the sends to every destination
+		auto bytes = std::make_shared<std::vector<char> >(msg.detach());
 
-		if(bytes.size() > INT_MAX) {
+		if(bytes->size() > INT_MAX) {
 			std::cerr << "MUI Error [comm_mpi_smart.h]: Trying to send more data than is possible with MPI_Isend." << std::endl
 					<< "This is likely because there is too much data per MPI rank." << std::endl
 					<< "The program will now abort. Try increasing the number of MPI ranks." << std::endl;
 			std::abort();
 		}
 
+		std::lock_guard<std::mutex> lock(send_mutex_);
+
 		for( int i = 0; i < remote_size_; i++ ) {
 			if( is_sending[i] ) {
-				send_buf.emplace_back(MPI_Request(), std::make_shared<std::vector<char> >(bytes));
-				MPI_Isend(send_buf.back().second->data(), send_buf.back().second->size(), MPI_BYTE, i, 0,
+				send_buf.emplace_back(MPI_Request(), bytes);
+				MPI_Isend(bytes->data(), bytes->size(), MPI_BYTE, i, 0,
 				          domain_remote_, &(send_buf.back().first));
 		 	}
 		}
-		// std::cout << "send_buf.emplace_back "<< send_buf.back().second->size() <<std::endl;
-
 
 		// Call non-blocking MPI_Test on outstanding MPI_Isend messages in buffer and if complete, pop
 		test_completion();
@@ -100,7 +119,10 @@ private:
 
 	message recv_impl_() {
 		// Catch any unsent MPI_Isend calls, non-blocking
-		test_completion();
+		{
+			std::lock_guard<std::mutex> lock(send_mutex_);
+			test_completion();
+		}
 
 		MPI_Status status;
 		MPI_Probe(MPI_ANY_SOURCE, 0, domain_remote_, &status);
@@ -108,13 +130,17 @@ private:
 		MPI_Get_count(&status, MPI_BYTE, &count);
 		std::vector<char> rcv_buf(count);
 		MPI_Recv( rcv_buf.data(), count, MPI_BYTE, status.MPI_SOURCE, status.MPI_TAG, domain_remote_, MPI_STATUS_IGNORE );
+		count_received_(status.MPI_SOURCE, count);
 		// std::cout << "recv_impl_ : rcv_buf.data() "<< rcv_buf.data() << " Count "<< count <<std::endl;
 		// for (char c : rcv_buf) {
 		// 	std::cout << c;
 		// }
 		// std::cout << std::endl;
 		// Catch any unsent MPI_Isend calls, non-blocking
-		test_completion();
+		{
+			std::lock_guard<std::mutex> lock(send_mutex_);
+			test_completion();
+		}
 
 		return message::make(std::move(rcv_buf));
 	}
@@ -128,7 +154,7 @@ private:
 	// }
 
 
-	/** \brief Non-blocking check for complete MPI_Isend calls
+	/** \brief Non-blocking check for complete MPI_Isend calls, send_mutex_ must be held
 	 */
 	void test_completion() {
 	  for( auto itr=send_buf.begin(), end=send_buf.end(); itr != end; ) {
@@ -142,6 +168,7 @@ private:
 	/** \brief Time-limited blocking check for complete MPI_Isend calls
 	 */
 	void test_completion_blocking() {
+	  std::lock_guard<std::mutex> lock(send_mutex_);
 	  while (send_buf.size() > 0) {
 			for( auto itr=send_buf.begin(), end=send_buf.end(); itr != end; ) {
 				MPI_Wait(&(itr->first), MPI_STATUS_IGNORE);
@@ -0,0 +1,456 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+******************************************************************************/
+
+/**
+ * @file comm_shm.h
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Shared-memory communicator for solvers running on the same node.
+ *
+ * Every rank owns one POSIX shared-memory segment holding a lock-free
+ * single-producer/single-consumer byte ring for each remote rank. Senders
+ * copy serialised messages straight into the receiver's ring and wake it
+ * through a futex in the segment. Ranks meet over MPI exactly like
+ * the "mpi" protocol (so "shm://domain/interface" URIs work the same), after
+ * which MPI is no longer used. Messages larger than a ring are streamed; what
+ * does not fit is moved on by a helper thread that wakes up whenever a peer
+ * reads. Rings shrink as the number of peers grows so that a segment stays
+ * within MUI_SHM_SEGMENT_SIZE.
+ */
+
+#ifndef COMM_SHM_H
+#define COMM_SHM_H
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <condition_variable>
+#include <signal.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include "../general/util.h"
+#include "comm.h"
+#include "comm_mpi.h"
+#include "comm_factory.h"
+#include "message/message.h"
+
+// Largest bytes of each ring, must be a power of two
+#ifndef MUI_SHM_RING_SIZE
+#define MUI_SHM_RING_SIZE (std::size_t(1) << 22)
+#endif
+
+// Bytes the rings of one segment may take together; rings are halved down to
+// MUI_SHM_MIN_RING_SIZE until they fit
+#ifndef MUI_SHM_SEGMENT_SIZE
+#define MUI_SHM_SEGMENT_SIZE (std::size_t(1) << 26)
+#endif
+
+#ifndef MUI_SHM_MIN_RING_SIZE
+#define MUI_SHM_MIN_RING_SIZE (std::size_t(1) << 16)
+#endif
+
+// Polls of the wake-up word before a receiver goes to sleep
+#ifndef MUI_SHM_SPIN
+#define MUI_SHM_SPIN 4096
+#endif
+
+namespace mui {
+
+class comm_shm : public comm_mpi {
+private:
+	static const std::size_t LINE = 64;  // keeps words written by different ranks apart
+	static const std::size_t PREFIX = 8; // length of a message in a ring
+	static const std::size_t NAME = 64;
+	static const std::size_t HOST = 256;
+
+	static_assert((MUI_SHM_RING_SIZE & (MUI_SHM_RING_SIZE-1)) == 0, "MUI_SHM_RING_SIZE must be a power of two");
+	static_assert((MUI_SHM_MIN_RING_SIZE & (MUI_SHM_MIN_RING_SIZE-1)) == 0, "MUI_SHM_MIN_RING_SIZE must be a power of two");
+
+	// start of every segment
+	struct control_ {
+		std::atomic<std::uint32_t> bell;    // bumped after bytes are written to, or read from, the owner's rings
+		std::atomic<std::uint32_t> waiters; // owner threads asleep on bell
+	};
+	// one direction of a rank pair
+	struct ring_ {
+		std::atomic<std::uint64_t> head; // bytes written, advanced by the sender only
+		char pad_[LINE-sizeof(std::uint64_t)];
+		std::atomic<std::uint64_t> tail; // bytes read, advanced by the owner only
+	};
+	// what ranks tell their peers at start up
+	struct card_ {
+		char host[HOST];
+		char name[NAME];
+		std::uint64_t ring_size;
+		std::int64_t pid;
+	};
+
+	struct segment_ {
+		char* base = nullptr;
+		std::size_t size = 0;
+		std::size_t ring_size = 0;
+		control_* control() const { return reinterpret_cast<control_*>(base); }
+		ring_* ring( int i ) const { return reinterpret_cast<ring_*>(base + LINE + i*(2*LINE+ring_size)); }
+		char* data( int i ) const { return base + LINE + i*(2*LINE+ring_size) + 2*LINE; }
+	};
+	// messages not yet fully written to one peer, offset counts the length prefix
+	struct outbox_ {
+		std::list<std::shared_ptr<const std::vector<char> > > que;
+		std::size_t offset = 0;
+	};
+	// message being read from one peer
+	struct inbox_ {
+		std::vector<char> buf;
+		std::size_t got = 0;
+		bool started = false;
+	};
+
+public:
+	comm_shm( const char URI[], const bool quiet, MPI_Comm world = MPI_COMM_WORLD ) : comm_mpi(URI, quiet, world) {
+		card_ card;
+		std::memset(&card, 0, sizeof(card));
+		gethostname(card.host, HOST-1);
+		std::snprintf(card.name, NAME, "/mui_%ld_%zx", static_cast<long>(getpid()),
+		              std::hash<std::string>()(uri_host_ + "/" + uri_path_));
+		card.ring_size = ring_size_(remote_size_);
+		card.pid = getpid();
+
+		std::vector<card_> cards(remote_size_);
+		MPI_Allgather(&card, sizeof(card_), MPI_BYTE, cards.data(), sizeof(card_), MPI_BYTE, domain_remote_);
+
+		// The check is symmetric, so a failure seen by any rank is reported on both sides
+		int bad = 0, remote_bad = 0;
+		for( auto& c: cards )
+			if( std::strncmp(c.host, card.host, HOST) != 0 ) bad = 1;
+		MPI_Allreduce(&bad, &remote_bad, 1, MPI_INT, MPI_MAX, domain_remote_);
+		if( bad || remote_bad )
+			throw std::runtime_error("MUI Error [comm_shm.h]: shm:// needs every peer rank on the same node");
+
+		own_ = map_(card.name, remote_size_, card.ring_size, true);
+		MPI_Barrier(domain_remote_);
+		remote_.reserve(remote_size_);
+		pids_.reserve(remote_size_);
+		for( auto& c: cards ) {
+			remote_.push_back(map_(c.name, local_size_, c.ring_size, false));
+			pids_.push_back(static_cast<pid_t>(c.pid));
+		}
+		MPI_Barrier(domain_remote_);
+		shm_unlink(card.name); // the mappings keep the memory alive
+
+		outboxes_.resize(remote_size_);
+		inboxes_.resize(remote_size_);
+		timeout_ = std::getenv("MUI_SHM_TIMEOUT") ? std::atoi(std::getenv("MUI_SHM_TIMEOUT")) : 60;
+	}
+
+	virtual ~comm_shm() {
+		// Deliver what is queued; keep reading meanwhile so that a peer doing the same is never blocked on us.
+		// Peers that exited are dropped, and whatever is left after MUI_SHM_TIMEOUT seconds is discarded.
+		std::unique_lock<std::mutex> lock(mutex_);
+		const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(timeout_);
+		while( backlog_() ) {
+			for( int q = 0; q < remote_size_; q++ )
+				if( !outboxes_[q].que.empty() && kill(pids_[q], 0) == -1 && errno == ESRCH ) outboxes_[q] = outbox_();
+			if( std::chrono::steady_clock::now() > end ) {
+				std::cout << "MUI Warning [comm_shm.h]: Messages not delivered within MUI_SHM_TIMEOUT are dropped" << std::endl;
+				break;
+			}
+			const std::uint32_t seq = own_.control()->bell.load();
+			if( !progress_() ) wait_(lock, seq);
+		}
+		closing_ = true;
+		lock.unlock();
+		idle_.notify_all();
+		ring_bell_(own_);
+		if( helper_.joinable() ) helper_.join();
+		for( auto& s: remote_ ) munmap(s.base, s.size);
+		if( own_.base ) munmap(own_.base, own_.size);
+	}
+
+	bool concurrent_send() const { return true; }
+
+	bool ready() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		if( mesgs_.empty() ) progress_();
+		return !mesgs_.empty();
+	}
+
+private:
+	void send_impl_( message msg, const std::vector<bool> &is_sending ) {
+		// One buffer is shared by every destination
+		std::shared_ptr<const std::vector<char> > bytes = std::make_shared<std::vector<char> >(msg.detach());
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		for( int i = 0; i < remote_size_; i++ )
+			if( is_sending[i] ) outboxes_[i].que.push_back(bytes);
+		progress_();
+		if( !backlog_() ) return;
+		// rings are full, hand the rest to the helper instead of waiting for the next call
+		if( !helper_.joinable() ) helper_ = std::thread(&comm_shm::help_, this);
+		else idle_.notify_one();
+	}
+
+	message recv_impl_() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		while( mesgs_.empty() ) {
+			const std::uint32_t seq = own_.control()->bell.load();
+			if( !progress_() ) wait_(lock, seq);
+		}
+		message msg = std::move(mesgs_.front());
+		mesgs_.pop_front();
+		return msg;
+	}
+
+	bool backlog_() const {
+		for( auto& o: outboxes_ ) if( !o.que.empty() ) return true;
+		return false;
+	}
+
+	/** \brief Helper thread, moves queued messages on as peers free space in their rings.
+	 * It only writes; reading stays with the receiving thread so that its wake-ups are not consumed here.
+	 */
+	void help_() {
+		std::unique_lock<std::mutex> lock(mutex_);
+		while( !closing_ ) {
+			if( !backlog_() ) {
+				idle_.wait(lock);
+				continue;
+			}
+			const std::uint32_t seq = own_.control()->bell.load();
+			bool moved = false;
+			for( int q = 0; q < remote_size_; q++ )
+				if( push_(q) ) moved = true;
+			if( !moved ) wait_(lock, seq);
+		}
+	}
+
+	/** \brief Moves bytes in and out of every ring without blocking, returns whether anything moved
+	 */
+	bool progress_() {
+		bool moved = false;
+		for( int q = 0; q < remote_size_; q++ ) {
+			if( push_(q) ) moved = true;
+			if( pull_(q) ) moved = true;
+		}
+		return moved;
+	}
+
+	bool push_( int q ) {
+		outbox_& box = outboxes_[q];
+		if( box.que.empty() ) return false;
+
+		const std::size_t size = remote_[q].ring_size;
+		ring_* r = remote_[q].ring(local_rank_);
+		char* data = remote_[q].data(local_rank_);
+		const std::uint64_t tail = r->tail.load(std::memory_order_acquire);
+		const std::uint64_t start = r->head.load(std::memory_order_relaxed);
+		std::uint64_t head = start;
+
+		while( !box.que.empty() && head - tail < size ) {
+			const std::vector<char>& msg = *box.que.front();
+			const std::size_t space = size - (head - tail);
+			if( box.offset < PREFIX ) {
+				const std::uint64_t len = msg.size();
+				const std::size_t n = std::min(PREFIX-box.offset, space);
+				copy_in_(data, size, head, reinterpret_cast<const char*>(&len) + box.offset, n);
+				head += n;
+				box.offset += n;
+				continue;
+			}
+			const std::size_t n = std::min(msg.size()-(box.offset-PREFIX), space);
+			copy_in_(data, size, head, msg.data()+(box.offset-PREFIX), n);
+			head += n;
+			box.offset += n;
+			if( box.offset == PREFIX+msg.size() ) {
+				box.que.pop_front();
+				box.offset = 0;
+			}
+		}
+
+		if( head == start ) return false;
+		r->head.store(head, std::memory_order_release);
+		ring_bell_(remote_[q]);
+		return true;
+	}
+
+	bool pull_( int q ) {
+		inbox_& box = inboxes_[q];
+		const std::size_t size = own_.ring_size;
+		ring_* r = own_.ring(q);
+		const char* data = own_.data(q);
+		const std::uint64_t head = r->head.load(std::memory_order_acquire);
+		const std::uint64_t start = r->tail.load(std::memory_order_relaxed);
+		std::uint64_t tail = start;
+
+		for(;;) {
+			if( !box.started ) {
+				if( head - tail < PREFIX ) break;
+				std::uint64_t len;
+				copy_out_(data, size, tail, reinterpret_cast<char*>(&len), PREFIX);
+				tail += PREFIX;
+				box.buf.resize(len);
+				box.got = 0;
+				box.started = true;
+			}
+			const std::size_t n = std::min<std::size_t>(head-tail, box.buf.size()-box.got);
+			copy_out_(data, size, tail, box.buf.data()+box.got, n);
+			tail += n;
+			box.got += n;
+			if( box.got < box.buf.size() ) break;
+			count_received_(q, box.buf.size());
+			mesgs_.emplace_back(message::make(std::move(box.buf)));
+			box.buf = std::vector<char>();
+			box.started = false;
+		}
+
+		if( tail == start ) return false;
+		r->tail.store(tail, std::memory_order_release);
+		ring_bell_(remote_[q]); // the sender may be waiting for space
+		return true;
+	}
+
+	static void copy_in_( char* data, std::size_t size, std::uint64_t pos, const char* src, std::size_t n ) {
+		const std::size_t at = pos & (size-1);
+		const std::size_t first = std::min(n, size-at);
+		std::memcpy(data+at, src, first);
+		std::memcpy(data, src+first, n-first);
+	}
+
+	static void copy_out_( const char* data, std::size_t size, std::uint64_t pos, char* dest, std::size_t n ) {
+		const std::size_t at = pos & (size-1);
+		const std::size_t first = std::min(n, size-at);
+		std::memcpy(dest, data+at, first);
+		std::memcpy(dest+first, data, n-first);
+	}
+
+	static void ring_bell_( const segment_& s ) {
+		s.control()->bell.fetch_add(1);
+		if( s.control()->waiters.load() )
+			syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&s.control()->bell), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+	}
+
+	/** \brief Sleeps until the own wake-up word moves on from seq, mutex_ is released meanwhile
+	 */
+	void wait_( std::unique_lock<std::mutex>& lock, std::uint32_t seq ) {
+		control_* c = own_.control();
+		lock.unlock();
+		for( int i = 0; i < MUI_SHM_SPIN && c->bell.load() == seq; i++ ) {}
+		if( c->bell.load() == seq ) {
+			// The timeout only guards against a peer that died mid-message
+			timespec timeout = {0, 100000000};
+			c->waiters.fetch_add(1);
+			syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&c->bell), FUTEX_WAIT, seq, &timeout, nullptr, 0);
+			c->waiters.fetch_sub(1);
+		}
+		lock.lock();
+	}
+
+	/** \brief Bytes of each of the given number of rings in one segment
+	 */
+	static std::size_t ring_size_( int rings ) {
+		std::size_t size = MUI_SHM_RING_SIZE;
+		while( size > MUI_SHM_MIN_RING_SIZE && rings*size > MUI_SHM_SEGMENT_SIZE ) size >>= 1;
+		return size;
+	}
+
+	static segment_ map_( const char* name, int rings, std::size_t ring_size, bool create ) {
+		segment_ s;
+		s.ring_size = ring_size;
+		s.size = LINE + rings*(2*LINE+ring_size);
+
+		int fd = shm_open(name, create ? O_CREAT|O_EXCL|O_RDWR : O_RDWR, S_IRUSR|S_IWUSR);
+		if( fd == -1 ) throw std::system_error(errno, std::system_category(), "MUI Error [comm_shm.h]: shm_open failed");
+		if( create && ftruncate(fd, s.size) == -1 ) {
+			int err = errno;
+			close(fd);
+			shm_unlink(name);
+			throw std::system_error(err, std::system_category(), "MUI Error [comm_shm.h]: ftruncate failed");
+		}
+		void* p = mmap(nullptr, s.size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+		int err = errno;
+		close(fd);
+		if( p == MAP_FAILED ) throw std::system_error(err, std::system_category(), "MUI Error [comm_shm.h]: mmap failed");
+		s.base = static_cast<char*>(p);
+
+		// ftruncate zero-fills, which is the initial state of every counter
+		if( create ) {
+			new (s.control()) control_();
+			s.control()->bell.store(0);
+			s.control()->waiters.store(0);
+			for( int i = 0; i < rings; i++ ) {
+				ring_* r = new (s.ring(i)) ring_();
+				r->head.store(0);
+				r->tail.store(0);
+			}
+		}
+		return s;
+	}
+
+	segment_ own_;                // rings into this rank, one per remote rank
+	std::vector<segment_> remote_; // segments of the remote ranks
+	std::vector<pid_t> pids_;      // processes of the remote ranks
+	std::vector<outbox_> outboxes_;
+	std::vector<inbox_> inboxes_;
+	std::list<message> mesgs_;
+	std::mutex mutex_;
+	std::thread helper_;           // started once a send does not fit the rings
+	std::condition_variable idle_; // helper waits here while nothing is queued
+	bool closing_ = false;
+	int timeout_;
+};
+
+inline communicator *create_comm_shm( const char URI[], const bool quiet ) {
+	return new comm_shm(URI, quiet);
+}
+
+const static bool comm_shm_registered_ = comm_factory::instance().link( "shm", create_comm_shm );
+
+}
+
+#endif
@@ -54,8 +54,10 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netdb.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <sys/epoll.h>
@@ -69,88 +71,29 @@
 #include <list>
 #include <exception>
 #include <atomic>
-
-#include "message.h"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <set>
+#include <system_error>
+#include <unordered_set>
+
+#include "../general/util.h"
+#include "../storage/stream.h"
+#include "../storage/stream_vector.h"
+#include "message/message.h"
 #include "comm.h"
 #include "lib_uri.h"
 #include "comm_factory.h"
 
 namespace mui {
 
-/*
- * smalluint is a integer which has variable length depend on
- * its value. smalluint requires small bytes if the value is smaller.
- * For example if the value is less than equal to 127, it only requires
- * one byte.
- * Format: the byte length is determined by the number of leading ones
- * of first byte.
- */
-struct smalluint {
-	uint64_t num;
-	static int detect_size( unsigned char byte ){
-		if(      byte <= 0x7fu ) return 1;
-		else if( byte <= 0xbfu ) return 2;
-		else if( byte <= 0xdfu ) return 3;
-		else if( byte <= 0xefu ) return 4;
-		else if( byte <= 0xf7u ) return 5;
-		else if( byte <= 0xfbu ) return 6;
-		else if( byte <= 0xfdu ) return 7;
-		else if( byte <= 0xfeu ) return 8;
-		else return 9;
-	}
-};
-
-inline istream& operator>> ( istream& stream, smalluint& sml )
-{
-	unsigned char byte;
-	stream >> byte;
-	uint64_t num = 0u;
-	int size;
-	if(      byte <= 0x7fu ) { size = 1; num = byte&0xffu; }
-	else if( byte <= 0xbfu ) { size = 2; num = byte&0x3fu; }
-	else if( byte <= 0xdfu ) { size = 3; num = byte&0x1fu; }
-	else if( byte <= 0xefu ) { size = 4; num = byte&0x0fu; }
-	else if( byte <= 0xf7u ) { size = 5; num = byte&0x07u; }
-	else if( byte <= 0xfbu ) { size = 6; num = byte&0x03u; }
-	else if( byte <= 0xfdu ) { size = 7; num = byte&0x01u; }
-	else if( byte <= 0xfeu ) size = 8;
-	else size = 9;
-
-	for( int i=0; i<size-1; ++i ){
-		unsigned char cur;
-		stream >> cur;
-		num = (num<<8u)|cur;
-	}
-	sml.num = num;
-	return stream;
-}
-inline ostream& operator<< ( ostream& stream, const smalluint& sml )
-{
-	uint64_t num = sml.num;
-	unsigned char bytes[9];
-	int size;
-	if(      num <= 0x000000000000007full ) size = 1;
-	else if( num <= 0x0000000000003fffull ) size = 2;
-	else if( num <= 0x00000000001fffffull ) size = 3;
-	else if( num <= 0x000000000fffffffull ) size = 4;
-	else if( num <= 0x00000007ffffffffull ) size = 5;
-	else if( num <= 0x000003ffffffffffull ) size = 6;
-	else if( num <= 0x0001ffffffffffffull ) size = 7;
-	else if( num <= 0x00ffffffffffffffull ) size = 8;
-	else size = 9;
-
-	for( int j=size-1; j>=0; --j ){
-		bytes[j] = (num&0xffull);
-		num >>= 8u;
-	}
-	bytes[0] |= (0xfff00ull>>(size-1));
-	stream.write((char*)bytes,size);
-
-	return stream;
-}
+// Bytes of the receive buffer of each connection
+#ifndef MUI_TCP_BUF_SIZE
+#define MUI_TCP_BUF_SIZE (std::size_t(1) << 18)
+#endif
 
 namespace {
-static const std::size_t MUI_TCP_BUF_SIZE = 4000;
 int SYSCHECK(int value){ // carefully use this. just like "SYSCHECK(close(fd));"
 	int err = errno;
 	if(value == -1) throw std::system_error(err, std::system_category());
@@ -193,6 +136,9 @@ private:
 
 /* poll_scheduler
  * A wrapper for epoll. It calls callback functions if the fd binded to callback becomes ready.
+ * schedule() marks an fd dirty from any thread; the marks are coalesced into a set that the
+ * polling thread drains after a single eventfd wake-up. fds may be added and removed while
+ * the polling thread runs; once remove() returns, the callback of that fd is not called again.
  * port to select? kqueue?
  */
 class poll_scheduler {
@@ -201,42 +147,44 @@ public:
 	static const uint64_t OUT = 4;
 	static const uint64_t CALL = 32;
 	static const uint64_t ET = 1u<<31; // edge triggered
+	static const int MAX_EVENTS = 64;  // events taken per wait, the rest stay ready for the next
 	
 	typedef std::function<void(uint64_t)> callback_t;
 	
-	poll_scheduler(int max){
-		buf_.reserve(max+1);
-		callbacks_.reserve(max+1);
+	poll_scheduler(): buf_(MAX_EVENTS) {
+		epfd_ = SYSCHECK(epoll_create(MAX_EVENTS));
 
-		epfd_ = SYSCHECK(epoll_create(max));
-
-		int pipes[2];
-		SYSCHECK(pipe(pipes));
-		pipe_read_.reset(pipes[0]);
-		pipe_write_.reset(pipes[1]);
-		add(pipe_read_, IN, std::bind(&poll_scheduler::pop_event_, this));
+		event_.reset(SYSCHECK(eventfd(0, EFD_NONBLOCK)));
+		add(event_, IN, std::bind(&poll_scheduler::pop_event_, this));
 	}
 	
 	~poll_scheduler() {
+		// fds may already be closed by their owners, which removes them from epoll anyway
 		for( auto& a: callbacks_ )
-			SYSCHECK(epoll_ctl(epfd_, EPOLL_CTL_DEL, a.first, NULL));
+			epoll_ctl(epfd_, EPOLL_CTL_DEL, a.first, NULL);
 	}
 
 	poll_scheduler(const poll_scheduler&) = delete;
 	poll_scheduler& operator=(const poll_scheduler&) = delete;
 	
-	void run() {
-		buf_.resize(callbacks_.size());
-		int nfd = epoll_wait(epfd_, buf_.data(), buf_.size(), 100);
+	// waits up to timeout ms (-1 forever, 0 not at all), returns the number of ready fds
+	int run(int timeout = -1) {
+		int nfd = epoll_wait(epfd_, buf_.data(), buf_.size(), timeout);
 		int err = errno;
-		if( nfd == 0 ) return;;
-		if( nfd == -1 && err == EAGAIN ) return;
+		if( nfd == 0 ) return 0;
+		if( nfd == -1 && (err == EAGAIN || err == EINTR) ) return 0;
 		else if( nfd == -1 ) throw std::system_error(err,std::system_category());
-		for( int i=0; i<nfd; ++i )
-			callbacks_[buf_[i].data.fd](translate_(buf_[i].events));
+		std::lock_guard<std::mutex> lock(callbacks_mutex_);
+		for( int i=0; i<nfd; ++i ) {
+			// the fd may have been removed since the wait returned
+			auto itr = callbacks_.find(buf_[i].data.fd);
+			if( itr != callbacks_.end() ) itr->second(translate_(buf_[i].events));
+		}
+		return nfd;
 	}
 
 	void add(int fd, uint64_t default_events, callback_t callback) {
+		std::lock_guard<std::mutex> lock(callbacks_mutex_);
 		callbacks_.emplace(fd, std::move(callback));
 		epoll_event ev;
 		ev.data.fd = fd;
@@ -248,15 +196,40 @@ public:
 			throw;
 		}
 	}
+	void remove(int fd) {
+		std::lock_guard<std::mutex> lock(callbacks_mutex_);
+		epoll_ctl(epfd_, EPOLL_CTL_DEL, fd, NULL);
+		callbacks_.erase(fd);
+	}
+	// fd -1 only wakes the polling thread
 	void schedule(int fd) {
-		SYSCHECK(write(pipe_write_, &fd, sizeof(int)));
+		bool wake;
+		{
+			std::lock_guard<std::mutex> lock(dirty_mutex_);
+			wake = dirty_.empty();
+			dirty_.insert(fd);
+		}
+		// a non-empty set means a wake-up is already on its way
+		if( wake ) {
+			uint64_t one = 1;
+			SYSCHECK(write(event_, &one, sizeof(one)));
+		}
 	}
 private:
 	void pop_event_() {
-		int fd;
-		SYSCHECK(read(pipe_read_, &fd, sizeof(int)));
-		if( fd != -1 )
-			callbacks_[fd](CALL);
+		uint64_t count;
+		if( read(event_, &count, sizeof(count)) == -1 && errno != EAGAIN )
+			throw std::system_error(errno,std::system_category());
+		std::unordered_set<int> dirty;
+		{
+			std::lock_guard<std::mutex> lock(dirty_mutex_);
+			dirty.swap(dirty_);
+		}
+		// called from run(), callbacks_mutex_ is held
+		for( int fd: dirty ) {
+			auto itr = fd != -1 ? callbacks_.find(fd) : callbacks_.end();
+			if( itr != callbacks_.end() ) itr->second(CALL);
+		}
 	}
 	uint64_t translate_(uint64_t ev) {
 		return (ev&EPOLLIN?IN:0u) | (ev&EPOLLOUT?OUT:0u) | (ev&EPOLLET?ET:0u);
@@ -266,68 +239,84 @@ private:
 	}
 	
 	std::unordered_map<int, callback_t> callbacks_;
+	std::mutex callbacks_mutex_;
 	std::vector<epoll_event> buf_;
 	unique_fd_ epfd_;
-	unique_fd_ pipe_read_, pipe_write_;
+	unique_fd_ event_;
+	std::mutex dirty_mutex_;
+	std::unordered_set<int> dirty_;
 };
 
-namespace {
-/* read_buffer
- * This manages buffers which will be used by read(3).
- * Internal use only.
+/* poll_thread
+ * The polling thread of the process. Every comm_fd adds its connections to the one shared
+ * poll_scheduler; the thread starts with the first comm_fd and stops with the last.
+ * It spins for the longest busy poll asked for by a live comm_fd before sleeping.
  */
-struct read_buffer : istream {
-	static const int BUFSIZE = MUI_TCP_BUF_SIZE;
-	struct node_t { char buf[BUFSIZE]; };
-	
-	std::pair<int,char*> get_buffer() {
-		if(nodes_.empty() || tail_ == BUFSIZE) {
-			nodes_.emplace_back();
-			tail_ = 0u;
-		}
-		return std::make_pair(BUFSIZE-tail_, nodes_.back().buf+tail_);
-	}
-	void move_tail(int size) { // consume bytes. size must be <= get_buffer().first
-		psize_ += size;
-		size_ += size;
-		tail_ += size;
-	}
-
-	void read(char* dest, std::size_t size) { // read bytes and seek
-		size_ -= size;
-		while(size) {
-			std::size_t sz = std::min<std::size_t>(size, (pcur_!=nodes_.size()-1?BUFSIZE-ccur_:tail_-ccur_));
-			dest = std::copy_n(nodes_[pcur_].buf+ccur_, sz, dest);
-			size -= sz;
-			ccur_ += sz;
-			if( size ) {
-				++pcur_;
-				ccur_ = 0u;
-			}
+class poll_thread {
+public:
+	static std::shared_ptr<poll_thread> instance() {
+		static std::mutex mutex;
+		static std::weak_ptr<poll_thread> current;
+		std::lock_guard<std::mutex> lock(mutex);
+		std::shared_ptr<poll_thread> p = current.lock();
+		if( !p ) {
+			p = std::make_shared<poll_thread>();
+			current = p;
 		}
+		return p;
+	}
+
+	poll_thread() {
+		die_.store(false);
+		busy_poll_.store(0);
+		std::thread th = std::thread(std::bind(&poll_thread::run_, this));
+		thread_.swap(th);
 	}
-	void revert() { // undo seeks
-		pcur_ = 0u;
-		ccur_ = head_;
-		size_ = psize_;
+	~poll_thread() {
+		die_.store(true);
+		poll_.schedule(-1);
+		thread_.join();
 	}
-	void detach() { // erase the used bytes
-		nodes_.erase(nodes_.begin(), nodes_.begin()+pcur_);
-		head_ = ccur_;
-		psize_ = size_;
+	poll_thread(const poll_thread&) = delete;
+	poll_thread& operator=(const poll_thread&) = delete;
+
+	poll_scheduler& scheduler() { return poll_; }
+
+	void add_busy_poll(int us) {
+		std::lock_guard<std::mutex> lock(busy_mutex_);
+		busy_polls_.insert(us);
+		busy_poll_.store(*busy_polls_.rbegin());
 	}
-	std::size_t size() const { return size_; }
-	
-	std::deque<node_t> nodes_;
-	std::size_t psize_ = 0u;
-	std::size_t size_ = 0u;
-	std::size_t pcur_ = 0u;
-	unsigned ccur_ = 0u;
-	unsigned head_ = 0u;
-	unsigned tail_ = 0u;
+	void remove_busy_poll(int us) {
+		std::lock_guard<std::mutex> lock(busy_mutex_);
+		busy_polls_.erase(busy_polls_.find(us));
+		busy_poll_.store(busy_polls_.empty() ? 0 : *busy_polls_.rbegin());
+	}
+private:
+	void run_() {
+		// keep polling without sleeping for the busy poll time after the last event
+		auto idle_since = std::chrono::steady_clock::now();
+		while(true){
+			if( die_ ) break;
+			const std::chrono::microseconds busy_poll(busy_poll_.load());
+			const bool spin = busy_poll.count() > 0 && std::chrono::steady_clock::now() - idle_since < busy_poll;
+			if( poll_.run(spin ? 0 : -1) > 0 ) idle_since = std::chrono::steady_clock::now();
+		}
+	}
+
+	poll_scheduler poll_;
+	std::atomic_bool die_;
+	std::atomic<int> busy_poll_; // microseconds
+	std::mutex busy_mutex_;
+	std::multiset<int> busy_polls_;
+	std::thread thread_;
 };
-}
 
+/* read_que
+ * Reads one connection into a reusable buffer and cuts it into messages.
+ * Every message is a size_t length followed by its bytes, the bytes are copied once
+ * into the message; bodies larger than the buffer are read straight into the message.
+ */
 class read_que {
 public:
 	read_que( unique_fd_&& fd, std::function<void(message)> callback )
@@ -336,159 +325,265 @@ public:
 	read_que& operator=( read_que&& ) = default;
 	
 	void try_recv(int){
+		if( buf_.empty() ) buf_.resize(MUI_TCP_BUF_SIZE);
 		while(true){
-			std::pair<int,char*> p = buf_.get_buffer();
-			ssize_t r = read(fd_, p.second, p.first);
+			const bool direct = in_body_ && body_.size() - got_ >= buf_.size();
+			ssize_t r = direct ? read(fd_, body_.data()+got_, body_.size()-got_)
+			                   : read(fd_, buf_.data()+end_, buf_.size()-end_);
 			int err = errno;
 			if( r > 0 ){
-				buf_.move_tail(r);
-				char c;
-				buf_ >> c;
-				buf_.revert();
-				std::uint64_t smlsize = smalluint::detect_size(c);
-				if( buf_.size() < smlsize) continue;
-
-				smalluint vecsize;
-				buf_ >> vecsize;
-				buf_.revert();
-				if( buf_.size() < smlsize + vecsize.num ) continue;
-
-				message msg;
-				buf_ >> msg;
-				callback_(std::move(msg));
-				buf_.detach();
-				continue;
+				if( direct ) {
+					got_ += r;
+					if( got_ == body_.size() ) deliver_();
+				}
+				else {
+					end_ += r;
+					parse_();
+				}
 			} else if( r == -1 && (err == EAGAIN || err == EWOULDBLOCK) ){
 				break;
-			}else if( r == -1 ) throw std::system_error(err,std::system_category());
-			else throw std::runtime_error("tcp connection is broken.\n");
+			}else if( r == -1 && err == EINTR ){
+				continue;
+			}else if( r == -1 && err != ECONNRESET ) throw std::system_error(err,std::system_category());
+			else break; // the peer has closed the connection
 		}
 	}
 	int get_fd() const { return fd_; }
 private:
+	// hand over every complete message in the buffer and keep the rest at its front
+	void parse_() {
+		std::size_t pos = 0;
+		while(true) {
+			if( !in_body_ ) {
+				if( end_ - pos < sizeof(std::size_t) ) break;
+				std::size_t size;
+				auto in = make_istream(buf_.data()+pos);
+				in >> size;
+				pos += sizeof(std::size_t);
+				body_.resize(size);
+				got_ = 0;
+				in_body_ = true;
+			}
+			std::size_t n = std::min(end_-pos, body_.size()-got_);
+			std::memcpy(body_.data()+got_, buf_.data()+pos, n);
+			pos += n;
+			got_ += n;
+			if( got_ < body_.size() ) break;
+			deliver_();
+		}
+		std::memmove(buf_.data(), buf_.data()+pos, end_-pos);
+		end_ -= pos;
+	}
+	void deliver_() {
+		callback_(message::make(std::move(body_)));
+		body_ = std::vector<char>();
+		in_body_ = false;
+	}
+
 	unique_fd_ fd_;
 	std::function<void(message)> callback_;
-	read_buffer buf_;
+	std::vector<char> buf_;
+	std::size_t end_ = 0;
+	std::vector<char> body_;
+	std::size_t got_ = 0;
+	bool in_body_ = false;
 };
 
+/* write_que
+ * Messages waiting for one connection. The bytes of a message are shared by every
+ * connection it goes to and are written with sendmsg straight from that buffer,
+ * several messages per call.
+ */
 class write_que {
 public:
 	explicit write_que(unique_fd_&& fd): fd_(std::move(fd)) {}
-	write_que(write_que&& rhs): fd_(std::move(rhs.fd_)), send_(std::move(send_)) {}
+	write_que(write_que&& rhs): fd_(std::move(rhs.fd_)), send_(std::move(rhs.send_)) {}
 	write_que& operator=(write_que&& rhs) {
 		std::swap(fd_, rhs.fd_);
 		send_.swap(rhs.send_);
 		return *this;
 	}
 	
+	static const int MAX_IOV = 64;
+
 	void try_send(int){
 		while(true) {
-			mutex_.lock();
-			auto iter = send_.begin();
-			auto end  = send_.end();
-			mutex_.unlock();
-			if(iter == end) break;
-			auto& p = *iter;
-
-			std::size_t sz = p.second.size() - p.first;
-			char* buf = p.second.data() + p.first;
-			ssize_t r = write(fd_, buf, sz);
+			iovec iov[MAX_IOV];
+			int n = gather(iov, MAX_IOV);
+			if( n == 0 ) break;
+
+			msghdr mh;
+			std::memset(&mh, 0, sizeof(mh));
+			mh.msg_iov = iov;
+			mh.msg_iovlen = n;
+			ssize_t r = sendmsg(fd_, &mh, MSG_NOSIGNAL);
 			int err = errno;
-			if( r == sz ) {
-				std::lock_guard<std::mutex> lock(mutex_);
-				send_.pop_front();
-			} else if( r > 0 ) {
-				p.first += r;
+			if( r > 0 ) {
+				advance(r);
 			} else if( r == -1 && (err == EAGAIN || err == EWOULDBLOCK) ){
 				break;
+			} else if( r == -1 && err == EINTR ) {
+				continue;
+			} else if( r == -1 && (err == EPIPE || err == ECONNRESET) ) {
+				// the peer has gone, nothing more can be delivered to it
+				clear();
+				break;
 			} else if( r == -1 ) throw std::system_error(err,std::system_category());
-			else throw std::runtime_error("tcp connection is broken.\n");
 		}
 	}
-	void push( std::vector<char> data ){
-		if( data.size() > std::numeric_limits<ssize_t>::max() ) 
-			throw std::range_error("cannot send data larger than ssize_t");
-		if( !data.empty() ) {
-			std::lock_guard<std::mutex> lock(mutex_);
-			send_.emplace_back(0u, std::move(data));
+	// points iov at the unsent bytes of the first queued messages, returns the entries used
+	int gather(iovec* iov, int max) {
+		// elements of send_ stay put while push() appends, only the sending thread removes them
+		std::lock_guard<std::mutex> lock(mutex_);
+		int n = 0;
+		for( auto itr = send_.begin(); itr != send_.end() && n+2 <= max; ++itr ) {
+			std::size_t off = itr->offset;
+			if( off < sizeof(itr->header) ) {
+				iov[n].iov_base = itr->header + off;
+				iov[n++].iov_len = sizeof(itr->header) - off;
+				off = 0;
+			}
+			else off -= sizeof(itr->header);
+			if( off < itr->data->size() ) {
+				iov[n].iov_base = const_cast<char*>(itr->data->data()) + off;
+				iov[n++].iov_len = itr->data->size() - off;
+			}
+		}
+		return n;
+	}
+	// marks done bytes as sent
+	void advance(std::size_t done) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		while( done ) {
+			entry_& e = send_.front();
+			std::size_t left = sizeof(e.header) + e.data->size() - e.offset;
+			if( done < left ) {
+				e.offset += done;
+				break;
+			}
+			done -= left;
+			send_.pop_front();
 		}
 	}
+	void clear() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		send_.clear();
+	}
+	bool empty() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return send_.empty();
+	}
+	void push( std::shared_ptr<const std::vector<char> > data ){
+		if( data->size() > static_cast<std::size_t>(std::numeric_limits<ssize_t>::max()) )
+			throw std::range_error("cannot send data larger than ssize_t");
+		std::lock_guard<std::mutex> lock(mutex_);
+		send_.emplace_back();
+		entry_& e = send_.back();
+		// the length goes first, streamed like every other size_t
+		auto out = make_ostream(e.header);
+		out << data->size();
+		e.data = std::move(data);
+	}
 	int get_fd() const { return fd_; }
 private:
+	struct entry_ {
+		char header[sizeof(std::size_t)];
+		std::shared_ptr<const std::vector<char> > data;
+		std::size_t offset = 0; // bytes of header and data already sent
+	};
+
 	unique_fd_ fd_;
 	std::mutex mutex_;
-	std::list<std::pair<std::size_t,std::vector<char> > > send_;
+	std::list<entry_> send_;
 };
 
 class comm_fd: public communicator {
 public:
-	comm_fd(int local_rank, int local_size, std::vector<unique_fd_>&& wfds, std::vector<unique_fd_>&& rfds)
-	: local_rank_(local_rank), local_size_(local_size), remote_size_(wfds.size()), poll_(rfds.size()+wfds.size()) {
+	// busy_poll: microseconds the polling thread and recv() spin before sleeping, 0 never spins
+	// timeout: seconds the destructor waits for queued messages to go out
+	comm_fd(int local_rank, int local_size, std::vector<unique_fd_>&& wfds, std::vector<unique_fd_>&& rfds, int busy_poll = 0, int timeout = 60)
+	: local_rank_(local_rank), local_size_(local_size), remote_size_(wfds.size()),
+	  busy_poll_(std::chrono::microseconds(busy_poll)), timeout_(timeout),
+	  thread_(poll_thread::instance()), poll_(thread_->scheduler()) {
 		assert(wfds.size() == rfds.size());
-		die_.store(false);
+		queued_.store(0);
 
 		rques_.reserve(rfds.size());
 		wques_.reserve(wfds.size());
 
-		for(auto& r: rfds) rques_.emplace_back(std::move(r),std::bind(&comm_fd::push_msg_,this,std::placeholders::_1));
+		for( std::size_t i=0; i<rfds.size(); ++i )
+			rques_.emplace_back(std::move(rfds[i]),std::bind(&comm_fd::push_msg_,this,int(i),std::placeholders::_1));
+		for(auto& w: wfds) wques_.emplace_back(std::move(w));
+		thread_->add_busy_poll(busy_poll);
 		for(auto& q: rques_)
 			poll_.add(q.get_fd(), poll_scheduler::IN | poll_scheduler::ET, std::bind(&read_que::try_recv,&q,std::placeholders::_1));
-		for(auto& w: wfds) wques_.emplace_back(std::move(w));
 		for(auto& q: wques_)
 			poll_.add(q.get_fd(), poll_scheduler::OUT | poll_scheduler::ET, std::bind(&write_que::try_send,&q,std::placeholders::_1));
-
-		std::thread th = std::thread(std::bind(&comm_fd::run_, this));
-		thread_.swap(th);
 	}
 	
 	~comm_fd() {
-		die_.store(true);
-		poll_.schedule(-1);
-		thread_.join();
+		// deliver what is still queued before the connections close, for at most timeout_ seconds
+		const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(timeout_);
+		for( auto& q: wques_ ) {
+			while( !q.empty() && std::chrono::steady_clock::now() < end ) {
+				poll_.schedule(q.get_fd());
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		for( auto& q: wques_ )
+			if( !q.empty() ) {
+				std::cout << "MUI Warning [comm_tcp.h]: Messages not delivered within MUI_TCP_TIMEOUT are dropped" << std::endl;
+				break;
+			}
+		for(auto& q: rques_) poll_.remove(q.get_fd());
+		for(auto& q: wques_) poll_.remove(q.get_fd());
+		thread_->remove_busy_poll(busy_poll_.count());
 	}
 	
 	int local_rank() const { return local_rank_; }
 	int local_size() const { return local_size_; }
 	int remote_size() const { return remote_size_; }
+	bool ready() { return queued_.load() > 0; }
 protected:
 	void send_impl_(message msg, const std::vector<bool>& dest) {
-		std::vector<char> v(streamed_size(msg));
-		auto stream = make_ostream(v.begin());
-		stream << msg;
+		// one buffer for every destination
+		std::shared_ptr<const std::vector<char> > data = std::make_shared<std::vector<char> >(msg.detach());
 		for( int i=0; i<remote_size(); ++i ) {
 			if(dest[i]){
-				wques_[i].push(v);
+				wques_[i].push(data);
 				poll_.schedule(wques_[i].get_fd());
 			}
 		}
 	}
 	message recv_impl_() {
+		if( busy_poll_.count() > 0 && queued_.load() == 0 ) {
+			auto end = std::chrono::steady_clock::now() + busy_poll_;
+			while( queued_.load() == 0 && std::chrono::steady_clock::now() < end ) {}
+		}
 		std::unique_lock<std::mutex> lock(recv_mutex_);
 		recv_cv_.wait(lock, [=](){ return !mesgs_.empty(); });
 		message msg = std::move(mesgs_.front());
 		mesgs_.pop_front();
+		queued_--;
 		return msg;
 	}
 private:
-	void push_msg_(message msg) {
+	void push_msg_(int peer, message msg) {
+		count_received_(peer, streamed_size(msg.id()) + msg.size());
 		std::unique_lock<std::mutex> lock(recv_mutex_);
 		mesgs_.emplace_back(std::move(msg));
+		queued_++;
 		recv_cv_.notify_one(); // only ONE thrad can cann comm_fd.recv_impl_();
 	}
 
-	void run_() {
-		while(true){
-			if( die_ ) break;
-			poll_.run();
-		}
-	}
-
 	int local_rank_, local_size_, remote_size_;
 
-	std::thread thread_;	
-	std::atomic_bool die_;
+	std::chrono::microseconds busy_poll_;
+	int timeout_;
+	std::atomic<std::size_t> queued_; // messages in mesgs_
 
-	poll_scheduler poll_;
+	std::shared_ptr<poll_thread> thread_;
+	poll_scheduler& poll_;
 	std::vector<read_que> rques_;
 	std::vector<write_que> wques_;
 
@@ -497,82 +592,354 @@ private:
 	std::list<message> mesgs_;
 };
 
-inline communicator* create_comm_tcp( const char* str ){
-	uri u(str);
-	bool is_server = u.host().empty();
+/* tcp_options
+ * Socket settings of the tcp communicator, read from the environment:
+ * MUI_TCP_NODELAY (default 1), MUI_TCP_SNDBUF and MUI_TCP_RCVBUF (bytes, 0 keeps the kernel default)
+ * MUI_TCP_BUSY_POLL (microseconds to spin before sleeping, for latency-critical loops) and
+ * MUI_TCP_TIMEOUT (seconds to wait for the rendezvous, and for queued messages on shutdown).
+ */
+struct tcp_options {
+	bool nodelay = true;
+	int sndbuf = 0;
+	int rcvbuf = 0;
+	int busy_poll = 0;
+	int timeout = 60;
+
+	static tcp_options from_env() {
+		tcp_options opt;
+		if( const char* v = std::getenv("MUI_TCP_NODELAY") ) opt.nodelay = std::atoi(v) != 0;
+		if( const char* v = std::getenv("MUI_TCP_SNDBUF") ) opt.sndbuf = std::atoi(v);
+		if( const char* v = std::getenv("MUI_TCP_RCVBUF") ) opt.rcvbuf = std::atoi(v);
+		if( const char* v = std::getenv("MUI_TCP_BUSY_POLL") ) opt.busy_poll = std::atoi(v);
+		if( const char* v = std::getenv("MUI_TCP_TIMEOUT") ) opt.timeout = std::atoi(v);
+		return opt;
+	}
+	// buffer sizes must be set before listen/connect to affect the window scale
+	void apply_buffers(int fd) const {
+		if( sndbuf > 0 ) SYSCHECK(setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &sndbuf, sizeof(sndbuf)));
+		if( rcvbuf > 0 ) SYSCHECK(setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf)));
+	}
+	void apply(int fd) const {
+		int flag = nodelay ? 1 : 0;
+		SYSCHECK(setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag)));
+	}
+};
 
-	struct free_addrinfo_ { void operator()( addrinfo* ptr ) const { freeaddrinfo(ptr); } };
-	unique_fd_ sock;
-	std::unique_ptr<addrinfo,free_addrinfo_> info;
-	addrinfo hint, *tmp=NULL;
+/* tcp_card_
+ * What every rank tells the rendezvous point: its domain and where its listener is.
+ * Integers are in network byte order.
+ */
+struct tcp_card_ {
+	char domain[256];
+	uint32_t rank;
+	uint32_t size;
+	uint32_t addr;
+	uint16_t port;
+};
 
-	std::memset((char*)&hint, 0, sizeof(hint));
-	hint.ai_family = AF_INET;	// use ip v4
-	hint.ai_socktype = SOCK_STREAM;	// TCP/IP
-	hint.ai_flags = AI_NUMERICSERV|(is_server?AI_PASSIVE:0);
-	
-	if(int err = getaddrinfo(is_server?0:u.host().c_str(), u.path().c_str(), &hint, &tmp))
-		throw std::runtime_error(gai_strerror(err));
-	info.reset(tmp);
-	
-	for(; tmp!=NULL; tmp = tmp->ai_next){
-		int s = socket(tmp->ai_family, tmp->ai_socktype, tmp->ai_protocol);
-		if(s == -1 ) continue;
-		sock.reset(s);
-		
-		if( is_server ){
-			if( bind(sock, tmp->ai_addr, tmp->ai_addrlen) != -1 ) break;
-		} else {
-			if( connect(sock, tmp->ai_addr, tmp->ai_addrlen) != -1 ) break;
+inline void tcp_send_all_(int fd, const void* buf, std::size_t n) {
+	const char* p = static_cast<const char*>(buf);
+	while( n ) {
+		ssize_t r = write(fd, p, n);
+		if( r == -1 && errno == EINTR ) continue;
+		SYSCHECK(r);
+		p += r;
+		n -= r;
+	}
+}
+
+inline void tcp_recv_all_(int fd, void* buf, std::size_t n) {
+	char* p = static_cast<char*>(buf);
+	while( n ) {
+		ssize_t r = read(fd, p, n);
+		if( r == -1 && errno == EINTR ) continue;
+		SYSCHECK(r);
+		if( r == 0 ) throw std::runtime_error("MUI Error [comm_tcp.h]: Connection closed during rendezvous");
+		p += r;
+		n -= r;
+	}
+}
+
+// Rank and size of this process within its own domain, from the launcher
+inline void tcp_rank_from_env_(int& rank, int& size) {
+	const char* vars[][2] = { {"MUI_TCP_RANK","MUI_TCP_SIZE"}, {"OMPI_COMM_WORLD_RANK","OMPI_COMM_WORLD_SIZE"},
+	                          {"PMI_RANK","PMI_SIZE"}, {"SLURM_PROCID","SLURM_NTASKS"} };
+	rank = 0;
+	size = 1;
+	for( auto& v: vars ) {
+		const char* r = std::getenv(v[0]);
+		const char* s = std::getenv(v[1]);
+		if( r && s ) {
+			rank = std::atoi(r);
+			size = std::atoi(s);
+			return;
 		}
 	}
-	if(tmp == NULL) throw std::runtime_error("tcp connection error.");
-	
-	unique_fd_ wfd, rfd;
-	
-	if( is_server ){
-		SYSCHECK(listen(sock,1));
-		wfd.reset(SYSCHECK(accept(sock,0,0)));
-		SYSCHECK(fcntl(wfd,F_SETFL,O_NONBLOCK));
-		rfd.reset(SYSCHECK(dup(wfd)));
-	} else {
-		SYSCHECK(fcntl(sock,F_SETFL,O_NONBLOCK));
-		wfd.swap(sock);
-		rfd.reset(SYSCHECK(dup(wfd)));
-	}
-	std::vector<mui::unique_fd_> w; w.emplace_back(std::move(wfd));
-	std::vector<mui::unique_fd_> r; r.emplace_back(std::move(rfd));
-	return static_cast<communicator*>(new comm_fd(0,1,std::move(w),std::move(r)));
 }
 
-const static bool comm_tcp_registered_ = comm_factory::instance().link( "tcp", create_comm_tcp );
+inline unique_fd_ tcp_listen_(uint32_t addr, uint16_t port, int backlog, const tcp_options& opt) {
+	unique_fd_ sock(SYSCHECK(socket(AF_INET, SOCK_STREAM, 0)));
+	int one = 1;
+	SYSCHECK(setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)));
+	opt.apply_buffers(sock);
+	sockaddr_in sa;
+	std::memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = addr;
+	sa.sin_port = port;
+	if( bind(sock, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == -1 ) return unique_fd_();
+	if( listen(sock, backlog) == -1 ) return unique_fd_();
+	return sock;
+}
 
-inline communicator* create_comm_shm( const char* str ){
-	uri u(str);
-	std::string patha = std::string("/dev/shm/") + u.host() + "_A";
-	std::string pathb = std::string("/dev/shm/") + u.host() + "_B";
-	bool is_wr = false;
-	
-	if(mkfifo(patha.c_str(), S_IRUSR | S_IWUSR)) {
+inline uint16_t tcp_port_of_(int fd) {
+	sockaddr_in sa;
+	socklen_t len = sizeof(sa);
+	SYSCHECK(getsockname(fd, reinterpret_cast<sockaddr*>(&sa), &len));
+	return sa.sin_port;
+}
+
+// Connects, retrying while the other end is not listening yet
+inline unique_fd_ tcp_connect_(uint32_t addr, uint16_t port, const tcp_options& opt, int timeout) {
+	auto end = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+	for(;;) {
+		unique_fd_ sock(SYSCHECK(socket(AF_INET, SOCK_STREAM, 0)));
+		opt.apply_buffers(sock);
+		sockaddr_in sa;
+		std::memset(&sa, 0, sizeof(sa));
+		sa.sin_family = AF_INET;
+		sa.sin_addr.s_addr = addr;
+		sa.sin_port = port;
+		if( connect(sock, reinterpret_cast<sockaddr*>(&sa), sizeof(sa)) == 0 ) return sock;
 		int err = errno;
-		if(err != EEXIST) throw std::system_error(err, std::system_category());
-		is_wr = true;
+		if( (err != ECONNREFUSED && err != ETIMEDOUT && err != EINTR) || std::chrono::steady_clock::now() > end )
+			throw std::system_error(err, std::system_category(), "MUI Error [comm_tcp.h]: Cannot connect");
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+}
+
+inline uint32_t tcp_resolve_(const std::string& host) {
+	addrinfo hint, *info = NULL;
+	std::memset(&hint, 0, sizeof(hint));
+	hint.ai_family = AF_INET;
+	hint.ai_socktype = SOCK_STREAM;
+	if( int err = getaddrinfo(host.c_str(), NULL, &hint, &info) )
+		throw std::runtime_error(std::string("MUI Error [comm_tcp.h]: ") + gai_strerror(err));
+	uint32_t addr = reinterpret_cast<sockaddr_in*>(info->ai_addr)->sin_addr.s_addr;
+	freeaddrinfo(info);
+	return addr;
+}
+
+/* tcp_registry_
+ * Collects the cards of every rank of both domains, then sends each rank the cards
+ * of the other domain ordered by rank.
+ */
+inline void tcp_registry_(unique_fd_ listener) {
+	std::vector<std::pair<unique_fd_,tcp_card_> > regs;
+	std::map<std::string, std::pair<uint32_t,uint32_t> > domains; // size, ranks seen
+
+	auto complete = [&]() {
+		if( domains.size() != 2 ) return false;
+		for( auto& d: domains ) if( d.second.second != d.second.first ) return false;
+		return true;
+	};
+	while( !complete() ) {
+		unique_fd_ fd(SYSCHECK(accept(listener, 0, 0)));
+		tcp_card_ card;
+		tcp_recv_all_(fd, &card, sizeof(card));
+		card.domain[sizeof(card.domain)-1] = '\0';
+		auto& d = domains[card.domain];
+		d.first = ntohl(card.size);
+		d.second++;
+		if( domains.size() > 2 )
+			throw std::runtime_error("MUI Error [comm_tcp.h]: More than two domains met on one tcp interface");
+		regs.emplace_back(std::move(fd), card);
+	}
+
+	for( auto& r: regs ) {
+		std::vector<tcp_card_> peers;
+		for( auto& o: regs )
+			if( std::strcmp(o.second.domain, r.second.domain) != 0 ) peers.push_back(o.second);
+		std::sort(peers.begin(), peers.end(), [](const tcp_card_& a, const tcp_card_& b) { return ntohl(a.rank) < ntohl(b.rank); });
+		uint32_t n = htonl(peers.size());
+		tcp_send_all_(r.first, &n, sizeof(n));
+		tcp_send_all_(r.first, peers.data(), peers.size()*sizeof(tcp_card_));
 	}
-	if(!is_wr)
-		if(int ret = mkfifo(pathb.c_str(), S_IRUSR | S_IWUSR))
-			throw std::system_error(errno, std::system_category());
-	
-	unique_fd_ afd = SYSCHECK(open(patha.c_str(), is_wr?O_RDONLY:O_WRONLY));
-	SYSCHECK(fcntl(afd,F_SETFL,O_NONBLOCK));
-	unique_fd_ bfd = SYSCHECK(open(pathb.c_str(), is_wr?O_WRONLY:O_RDONLY));
-	SYSCHECK(fcntl(bfd,F_SETFL,O_NONBLOCK));
-	
-	std::vector<mui::unique_fd_> w; w.emplace_back(std::move(is_wr?bfd:afd));
-	std::vector<mui::unique_fd_> r; r.emplace_back(std::move(is_wr?afd:bfd));
-	return static_cast<communicator*>(new comm_fd(0,1,std::move(w),std::move(r)));
 }
 
-const static bool comm_shm_registered_ = comm_factory::instance().link( "shm", create_comm_shm);
+/* tcp_mesh
+ * Connected, non-blocking sockets to every rank of the other domain, indexed by remote rank.
+ */
+struct tcp_mesh {
+	int rank;
+	int size;
+	tcp_options opt;
+	std::vector<unique_fd_> fds;
+};
+
+/* tcp_connect_mesh
+ * URI: tcp://domain/interface, like mpi://. The rank and size of each process within its
+ * domain come from MUI_TCP_RANK/MUI_TCP_SIZE or the launcher (Open MPI, PMI, Slurm).
+ * Ranks meet at a rendezvous point, either MUI_TCP_RENDEZVOUS=host:port (hosted by whichever
+ * process can bind it) or, by default, a port file MUI_TCP_DIR/mui_tcp_<interface>.port
+ * (MUI_TCP_DIR defaults to /tmp) created by the first process to arrive. The port file only
+ * names a port and is reached on the loopback address, so runs spanning several nodes must set
+ * MUI_TCP_RENDEZVOUS. Every rank then holds one connection to every rank of the other domain.
+ */
+inline tcp_mesh tcp_connect_mesh( const char URI[] ){
+	uri u(URI);
+	const tcp_options opt = tcp_options::from_env();
+	const int timeout = opt.timeout;
+
+	int rank, size;
+	tcp_rank_from_env_(rank, size);
+	if( u.host().size() >= sizeof(tcp_card_::domain) )
+		throw std::runtime_error("MUI Error [comm_tcp.h]: Domain name too long");
+
+	// Find or become the rendezvous point
+	unique_fd_ registry;
+	uint32_t reg_addr;
+	uint16_t reg_port;
+	std::string port_file;
+	if( const char* r = std::getenv("MUI_TCP_RENDEZVOUS") ) {
+		std::string s(r);
+		std::size_t colon = s.rfind(':');
+		if( colon == std::string::npos )
+			throw std::runtime_error("MUI Error [comm_tcp.h]: MUI_TCP_RENDEZVOUS must be host:port");
+		reg_addr = tcp_resolve_(s.substr(0, colon));
+		reg_port = htons(std::atoi(s.substr(colon+1).c_str()));
+		registry = tcp_listen_(reg_addr, reg_port, SOMAXCONN, tcp_options());
+	}
+	else {
+		port_file = std::string(std::getenv("MUI_TCP_DIR") ? std::getenv("MUI_TCP_DIR") : "/tmp") + "/mui_tcp_" + u.path() + ".port";
+		int fd = open(port_file.c_str(), O_CREAT|O_EXCL|O_WRONLY, S_IRUSR|S_IWUSR);
+		if( fd != -1 ) {
+			unique_fd_ file(fd);
+			reg_addr = htonl(INADDR_LOOPBACK);
+			registry = tcp_listen_(htonl(INADDR_ANY), 0, SOMAXCONN, tcp_options());
+			if( !registry ) throw std::runtime_error("MUI Error [comm_tcp.h]: Cannot open rendezvous listener");
+			reg_port = tcp_port_of_(registry);
+			char line[64];
+			int n = std::snprintf(line, sizeof(line), "%u\n", static_cast<unsigned>(ntohs(reg_port)));
+			tcp_send_all_(file, line, n);
+		}
+		else {
+			if( errno != EEXIST ) throw std::system_error(errno, std::system_category(), "MUI Error [comm_tcp.h]: Cannot create " + port_file);
+			// Wait for the host to finish writing the port
+			auto end = std::chrono::steady_clock::now() + std::chrono::seconds(timeout);
+			unsigned port = 0;
+			for(;;) {
+				std::ifstream in(port_file);
+				std::string line;
+				if( std::getline(in, line) && !in.eof() ) {
+					port = std::atoi(line.c_str());
+					break;
+				}
+				if( std::chrono::steady_clock::now() > end )
+					throw std::runtime_error("MUI Error [comm_tcp.h]: Timed out reading " + port_file + ", remove it if it is left over from an earlier run");
+				std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			}
+			reg_addr = htonl(INADDR_LOOPBACK);
+			reg_port = htons(port);
+		}
+	}
+
+	std::exception_ptr reg_error;
+	std::thread reg_thread;
+	if( registry ) {
+		reg_thread = std::thread([&reg_error](unique_fd_ l) {
+			try { tcp_registry_(std::move(l)); }
+			catch(...) { reg_error = std::current_exception(); }
+		}, std::move(registry));
+	}
+
+	std::vector<tcp_card_> peers;
+	unique_fd_ listener;
+	try {
+		// Listener for the data connections, on an ephemeral port
+		listener = tcp_listen_(htonl(INADDR_ANY), 0, SOMAXCONN, opt);
+		if( !listener ) throw std::runtime_error("MUI Error [comm_tcp.h]: Cannot open listener");
+
+		unique_fd_ reg = tcp_connect_(reg_addr, reg_port, tcp_options(), timeout);
+		sockaddr_in self;
+		socklen_t len = sizeof(self);
+		SYSCHECK(getsockname(reg, reinterpret_cast<sockaddr*>(&self), &len)); // the interface that reaches the others
+
+		tcp_card_ card;
+		std::memset(&card, 0, sizeof(card));
+		std::strncpy(card.domain, u.host().c_str(), sizeof(card.domain)-1);
+		card.rank = htonl(rank);
+		card.size = htonl(size);
+		card.addr = self.sin_addr.s_addr;
+		card.port = tcp_port_of_(listener);
+		tcp_send_all_(reg, &card, sizeof(card));
+
+		uint32_t n;
+		tcp_recv_all_(reg, &n, sizeof(n));
+		peers.resize(ntohl(n));
+		tcp_recv_all_(reg, peers.data(), peers.size()*sizeof(tcp_card_));
+	}
+	catch(...) {
+		if( reg_thread.joinable() ) reg_thread.join();
+		throw;
+	}
+	if( reg_thread.joinable() ) {
+		reg_thread.join();
+		if( !port_file.empty() ) unlink(port_file.c_str());
+		if( reg_error ) std::rethrow_exception(reg_error);
+	}
+
+	// The domain that sorts first connects, the other accepts
+	const int remote_size = peers.size();
+	std::vector<unique_fd_> w(remote_size);
+	if( u.host() < std::string(peers.front().domain) ) {
+		for( int i = 0; i < remote_size; ++i ) {
+			w[i] = tcp_connect_(peers[i].addr, peers[i].port, opt, timeout);
+			uint32_t me = htonl(rank);
+			tcp_send_all_(w[i], &me, sizeof(me));
+		}
+	}
+	else {
+		for( int i = 0; i < remote_size; ++i ) {
+			unique_fd_ fd(SYSCHECK(accept(listener, 0, 0)));
+			uint32_t from;
+			tcp_recv_all_(fd, &from, sizeof(from));
+			from = ntohl(from);
+			if( from >= static_cast<uint32_t>(remote_size) || w[from] )
+				throw std::runtime_error("MUI Error [comm_tcp.h]: Unexpected connection during rendezvous");
+			w[from] = std::move(fd);
+		}
+	}
+	for( int i = 0; i < remote_size; ++i ) {
+		opt.apply(w[i]);
+		SYSCHECK(fcntl(w[i],F_SETFL,O_NONBLOCK));
+	}
+
+	tcp_mesh mesh;
+	mesh.rank = rank;
+	mesh.size = size;
+	mesh.opt = opt;
+	mesh.fds = std::move(w);
+	return mesh;
+}
+
+/* create_comm_tcp
+ * Serves every connection of the mesh from the epoll thread shared by the process.
+ */
+inline communicator* create_comm_tcp( const char URI[], const bool quiet ){
+	tcp_mesh mesh = tcp_connect_mesh(URI);
+	const int remote_size = mesh.fds.size();
+
+	std::vector<unique_fd_> r(remote_size);
+	for( int i = 0; i < remote_size; ++i ) r[i].reset(SYSCHECK(dup(mesh.fds[i])));
+
+	if( !quiet || mesh.rank == 0 )
+		std::cout << "MUI [comm_tcp.h]: Identifier: " << URI << ", Domain size: " << mesh.size << ", Peers: " << remote_size << std::endl;
+
+	return static_cast<communicator*>(new comm_fd(mesh.rank,mesh.size,std::move(mesh.fds),std::move(r),mesh.opt.busy_poll,mesh.opt.timeout));
+}
+
+const static bool comm_tcp_registered_ = comm_factory::instance().link( "tcp", create_comm_tcp );
 
 }
 
@@ -587,8 +954,7 @@ void print( mui::message msg )
 
 int main(int argc, char **argv)
 {
-	//std::unique_ptr<mui::communicator> c(mui::create_comm_tcp(argc<2?"tcp:///37129":"tcp://localhost/37129"));
-	std::unique_ptr<mui::communicator> c(mui::create_comm_shm("shm://my_pipe/"));
+	std::unique_ptr<mui::communicator> c(mui::create_comm_tcp(argc<2?"tcp:///37129":"tcp://localhost/37129"));
 
 	c->send(mui::message::make("test",std::string("Hello, ")));
 	mui::message msg = c->recv();
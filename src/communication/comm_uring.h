@@ -0,0 +1,447 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+******************************************************************************/
+
+/**
+ * @file comm_uring.h
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief io_uring backend of the tcp communicator, selected with
+ * "tcp+uring://domain/interface".
+ *
+ * Ranks connect exactly as for tcp:// (see tcp_connect_mesh). One thread
+ * then drives every socket through an io_uring set up with raw system
+ * calls: sockets are registered files, each receives with one multishot
+ * recv that picks from a group of buffers provided to the kernel, and
+ * sends are sendmsg calls gathering queued messages from their shared
+ * buffers. Where the kernel lacks these features the plain tcp://
+ * communicator is used instead.
+ *
+ * Only built with MUI_IO_URING (CMake option USE_IO_URING), as the
+ * multishot receives need io_uring headers from Linux 6.0 or newer.
+ */
+
+#ifndef COMM_URING_H
+#define COMM_URING_H
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include "comm_tcp.h"
+
+#if !defined(IORING_RECV_MULTISHOT) || !defined(IOSQE_CQE_SKIP_SUCCESS)
+#error "MUI Error [comm_uring.h]: tcp+uring:// needs io_uring headers from Linux 6.0 or newer, build without MUI_IO_URING"
+#endif
+
+// Provided receive buffers shared by all connections, and their size in bytes
+#ifndef MUI_URING_BUFS
+#define MUI_URING_BUFS 64
+#endif
+#ifndef MUI_URING_BUF_SIZE
+#define MUI_URING_BUF_SIZE (1 << 16)
+#endif
+
+namespace mui {
+
+class comm_uring: public communicator {
+	enum : uint64_t { RECV = 1, SEND = 2, WAKE = 3, PROVIDE = 4 }; // kind of request, high half of user_data
+	static const uint16_t GROUP = 0;                                  // id of the provided buffer group
+
+	// per connection state, touched by the ring thread only
+	struct peer_ {
+		msghdr mh;
+		iovec iov[write_que::MAX_IOV];
+		bool sending = false;
+		// message being received
+		char header[sizeof(std::size_t)];
+		std::size_t header_got = 0;
+		std::vector<char> body;
+		std::size_t got = 0;
+	};
+
+public:
+	// fds are only taken over if the ring can be set up, so a caller may fall back on them
+	comm_uring(int local_rank, int local_size, std::vector<unique_fd_>& fds)
+	: local_rank_(local_rank), local_size_(local_size), remote_size_(fds.size()), peers_(fds.size()) {
+		try {
+			// one recv and one send per connection, the wake-up read and the returned buffers
+			setup_ring_(2*remote_size_ + MUI_URING_BUFS + 8);
+			setup_buffers_();
+
+			std::vector<int> raw(fds.begin(), fds.end());
+			if( syscall(__NR_io_uring_register, int(ring_fd_), IORING_REGISTER_FILES, raw.data(), raw.size()) < 0 )
+				throw std::system_error(errno, std::system_category(), "MUI Error [comm_uring.h]: Cannot register sockets");
+		}
+		catch(...) {
+			unmap_();
+			throw;
+		}
+
+		wake_.reset(SYSCHECK(eventfd(0, EFD_NONBLOCK)));
+		die_.store(false);
+		wques_.reserve(fds.size());
+		for( auto& fd: fds ) wques_.emplace_back(std::move(fd));
+
+		thread_ = std::thread(&comm_uring::run_, this);
+	}
+
+	~comm_uring() {
+		// deliver what is still queued before the connections close
+		for( std::size_t i = 0; i < wques_.size(); ++i ) {
+			while( !wques_[i].empty() ) {
+				schedule_(i);
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+		}
+		die_.store(true);
+		schedule_(-1);
+		thread_.join();
+		unmap_();
+	}
+
+	int local_rank() const { return local_rank_; }
+	int local_size() const { return local_size_; }
+	int remote_size() const { return remote_size_; }
+	bool ready() {
+		std::lock_guard<std::mutex> lock(recv_mutex_);
+		return !mesgs_.empty();
+	}
+
+protected:
+	void send_impl_(message msg, const std::vector<bool>& dest) {
+		// one buffer for every destination
+		std::shared_ptr<const std::vector<char> > data = std::make_shared<std::vector<char> >(msg.detach());
+		for( int i=0; i<remote_size_; ++i ) {
+			if( dest[i] ) {
+				wques_[i].push(data);
+				schedule_(i);
+			}
+		}
+	}
+	message recv_impl_() {
+		std::unique_lock<std::mutex> lock(recv_mutex_);
+		recv_cv_.wait(lock, [=](){ return !mesgs_.empty(); });
+		message msg = std::move(mesgs_.front());
+		mesgs_.pop_front();
+		return msg;
+	}
+
+private:
+	// marks connection i as having data to send and wakes the ring thread once per batch
+	void schedule_(int i) {
+		bool wake;
+		{
+			std::lock_guard<std::mutex> lock(dirty_mutex_);
+			wake = dirty_.empty();
+			dirty_.insert(i);
+		}
+		if( wake ) {
+			uint64_t one = 1;
+			SYSCHECK(write(wake_, &one, sizeof(one)));
+		}
+	}
+
+	void run_() {
+		for( int i = 0; i < remote_size_; ++i ) arm_recv_(i);
+		arm_wake_();
+
+		while( !die_ ) {
+			enter_(1);
+			unsigned head = *cq_khead_;
+			while( head != __atomic_load_n(cq_ktail_, __ATOMIC_ACQUIRE) ) {
+				const io_uring_cqe cqe = cqes_[head & cq_mask_];
+				__atomic_store_n(cq_khead_, ++head, __ATOMIC_RELEASE);
+				complete_(cqe);
+			}
+		}
+	}
+
+	// submits the queued requests and waits for wait completions
+	void enter_(unsigned wait) {
+		unsigned submit = sq_tail_ - *sq_ktail_;
+		__atomic_store_n(sq_ktail_, sq_tail_, __ATOMIC_RELEASE);
+		int r = syscall(__NR_io_uring_enter, int(ring_fd_), submit, wait, wait ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+		if( r < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY )
+			throw std::system_error(errno, std::system_category(), "MUI Error [comm_uring.h]: io_uring_enter");
+	}
+
+	void complete_( const io_uring_cqe& cqe ) {
+		const uint64_t kind = cqe.user_data >> 32;
+		const int i = static_cast<int>(cqe.user_data & 0xffffffffu);
+
+		if( kind == RECV ) {
+			if( cqe.res > 0 ) {
+				const unsigned bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+				feed_(i, bufs_ + bid*MUI_URING_BUF_SIZE, cqe.res);
+				recycle_(bid);
+			}
+			const bool gone = cqe.res == 0 || cqe.res == -ECONNRESET; // the peer has gone, stay disarmed
+			if( cqe.res < 0 && !gone && cqe.res != -ENOBUFS && cqe.res != -EINTR )
+				throw std::system_error(-cqe.res, std::system_category(), "MUI Error [comm_uring.h]: recv");
+			if( !gone && !(cqe.flags & IORING_CQE_F_MORE) ) arm_recv_(i);
+		}
+		else if( kind == SEND ) {
+			peers_[i].sending = false;
+			if( cqe.res > 0 ) wques_[i].advance(cqe.res);
+			else if( cqe.res == -EPIPE || cqe.res == -ECONNRESET ) wques_[i].clear(); // nothing more can be delivered
+			else if( cqe.res < 0 && cqe.res != -EAGAIN && cqe.res != -EINTR )
+				throw std::system_error(-cqe.res, std::system_category(), "MUI Error [comm_uring.h]: send");
+			send_(i);
+		}
+		else if( kind == WAKE ) {
+			std::unordered_set<int> dirty;
+			{
+				std::lock_guard<std::mutex> lock(dirty_mutex_);
+				dirty.swap(dirty_);
+			}
+			for( int j: dirty ) if( j != -1 ) send_(j);
+			arm_wake_();
+		}
+		else if( kind == PROVIDE ) // only failures complete
+			throw std::system_error(-cqe.res, std::system_category(), "MUI Error [comm_uring.h]: Cannot return receive buffer");
+	}
+
+	// cuts the bytes of connection p into messages, each a size_t length followed by its bytes
+	void feed_( int i, const char* data, std::size_t n ) {
+		peer_& p = peers_[i];
+		while( n ) {
+			if( p.header_got < sizeof(p.header) ) {
+				std::size_t k = std::min(n, sizeof(p.header) - p.header_got);
+				std::memcpy(p.header + p.header_got, data, k);
+				p.header_got += k;
+				data += k;
+				n -= k;
+				if( p.header_got < sizeof(p.header) ) break;
+				std::size_t size;
+				auto in = make_istream(p.header);
+				in >> size;
+				p.body.resize(size);
+				p.got = 0;
+			}
+			std::size_t k = std::min(n, p.body.size() - p.got);
+			std::memcpy(p.body.data() + p.got, data, k);
+			p.got += k;
+			data += k;
+			n -= k;
+			if( p.got == p.body.size() ) {
+				count_received_(i, p.body.size());
+				{
+					std::lock_guard<std::mutex> lock(recv_mutex_);
+					mesgs_.emplace_back(message::make(std::move(p.body)));
+				}
+				recv_cv_.notify_one();
+				p.body = std::vector<char>();
+				p.header_got = 0;
+			}
+		}
+	}
+
+	void send_(int i) {
+		peer_& p = peers_[i];
+		if( p.sending ) return;
+		int n = wques_[i].gather(p.iov, write_que::MAX_IOV);
+		if( n == 0 ) return;
+		std::memset(&p.mh, 0, sizeof(p.mh));
+		p.mh.msg_iov = p.iov;
+		p.mh.msg_iovlen = n;
+		io_uring_sqe* sqe = sqe_();
+		sqe->opcode = IORING_OP_SENDMSG;
+		sqe->flags = IOSQE_FIXED_FILE;
+		sqe->fd = i;
+		sqe->addr = reinterpret_cast<uint64_t>(&p.mh);
+		sqe->msg_flags = MSG_NOSIGNAL;
+		sqe->user_data = (SEND << 32) | i;
+		p.sending = true;
+	}
+
+	void arm_recv_(int i) {
+		io_uring_sqe* sqe = sqe_();
+		sqe->opcode = IORING_OP_RECV;
+		sqe->flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+		sqe->fd = i;
+		sqe->ioprio = IORING_RECV_MULTISHOT;
+		sqe->buf_group = GROUP;
+		sqe->user_data = (RECV << 32) | i;
+	}
+
+	void arm_wake_() {
+		io_uring_sqe* sqe = sqe_();
+		sqe->opcode = IORING_OP_READ;
+		sqe->fd = wake_;
+		sqe->addr = reinterpret_cast<uint64_t>(&wake_count_);
+		sqe->len = sizeof(wake_count_);
+		sqe->user_data = WAKE << 32;
+	}
+
+	// hands count buffers from bid on back to the kernel
+	void provide_(unsigned bid, unsigned count, uint32_t flags) {
+		io_uring_sqe* sqe = sqe_();
+		sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+		sqe->flags = flags;
+		sqe->fd = count;
+		sqe->addr = reinterpret_cast<uint64_t>(bufs_ + bid*MUI_URING_BUF_SIZE);
+		sqe->len = MUI_URING_BUF_SIZE;
+		sqe->buf_group = GROUP;
+		sqe->off = bid;
+		sqe->user_data = PROVIDE << 32;
+	}
+	void recycle_(unsigned bid) { provide_(bid, 1, IOSQE_CQE_SKIP_SUCCESS); }
+
+	io_uring_sqe* sqe_() {
+		if( sq_tail_ - __atomic_load_n(sq_khead_, __ATOMIC_ACQUIRE) == sq_entries_ ) enter_(0);
+		io_uring_sqe* sqe = &sqes_[sq_tail_ & sq_mask_];
+		std::memset(sqe, 0, sizeof(*sqe));
+		sq_array_[sq_tail_ & sq_mask_] = sq_tail_ & sq_mask_;
+		++sq_tail_;
+		return sqe;
+	}
+
+	void setup_ring_(unsigned entries) {
+		io_uring_params p;
+		std::memset(&p, 0, sizeof(p));
+		int fd = syscall(__NR_io_uring_setup, entries, &p);
+		if( fd < 0 ) throw std::system_error(errno, std::system_category(), "MUI Error [comm_uring.h]: io_uring_setup");
+		ring_fd_.reset(fd);
+
+		sq_size_ = p.sq_off.array + p.sq_entries*sizeof(unsigned);
+		cq_size_ = p.cq_off.cqes + p.cq_entries*sizeof(io_uring_cqe);
+		if( p.features & IORING_FEAT_SINGLE_MMAP ) sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+		sq_ptr_ = map_(sq_size_, IORING_OFF_SQ_RING);
+		cq_ptr_ = (p.features & IORING_FEAT_SINGLE_MMAP) ? sq_ptr_ : map_(cq_size_, IORING_OFF_CQ_RING);
+		sqes_size_ = p.sq_entries*sizeof(io_uring_sqe);
+		sqes_ = static_cast<io_uring_sqe*>(map_(sqes_size_, IORING_OFF_SQES));
+
+		char* sq = static_cast<char*>(sq_ptr_);
+		char* cq = static_cast<char*>(cq_ptr_);
+		sq_khead_ = reinterpret_cast<unsigned*>(sq + p.sq_off.head);
+		sq_ktail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+		sq_entries_ = p.sq_entries;
+		sq_mask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+		sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+		sq_tail_ = *sq_ktail_;
+		cq_khead_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+		cq_ktail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+		cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+		cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+	}
+
+	// provides all receive buffers, which also tells whether the kernel can select buffers at all
+	void setup_buffers_() {
+		bufs_ = static_cast<char*>(mmap(nullptr, MUI_URING_BUFS*MUI_URING_BUF_SIZE, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0));
+		if( bufs_ == MAP_FAILED ) {
+			bufs_ = nullptr;
+			throw std::system_error(errno, std::system_category(), "MUI Error [comm_uring.h]: mmap");
+		}
+		provide_(0, MUI_URING_BUFS, 0);
+		enter_(1);
+		const io_uring_cqe cqe = cqes_[*cq_khead_ & cq_mask_];
+		__atomic_store_n(cq_khead_, *cq_khead_+1, __ATOMIC_RELEASE);
+		if( cqe.res < 0 )
+			throw std::system_error(-cqe.res, std::system_category(), "MUI Error [comm_uring.h]: Cannot provide receive buffers");
+	}
+
+	void unmap_() {
+		if( bufs_ ) munmap(bufs_, MUI_URING_BUFS*MUI_URING_BUF_SIZE);
+		if( sqes_ ) munmap(sqes_, sqes_size_);
+		if( cq_ptr_ && cq_ptr_ != sq_ptr_ ) munmap(cq_ptr_, cq_size_);
+		if( sq_ptr_ ) munmap(sq_ptr_, sq_size_);
+	}
+
+	void* map_(std::size_t size, off_t offset) {
+		void* p = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_SHARED|MAP_POPULATE, ring_fd_, offset);
+		if( p == MAP_FAILED ) throw std::system_error(errno, std::system_category(), "MUI Error [comm_uring.h]: mmap");
+		return p;
+	}
+
+	int local_rank_, local_size_, remote_size_;
+
+	unique_fd_ ring_fd_;
+	void* sq_ptr_ = nullptr;
+	void* cq_ptr_ = nullptr;
+	io_uring_sqe* sqes_ = nullptr;
+	std::size_t sq_size_ = 0, cq_size_ = 0, sqes_size_ = 0;
+	unsigned* sq_khead_ = nullptr;
+	unsigned* sq_ktail_ = nullptr;
+	unsigned* sq_array_ = nullptr;
+	unsigned sq_mask_ = 0, sq_entries_ = 0, sq_tail_ = 0;
+	unsigned* cq_khead_ = nullptr;
+	unsigned* cq_ktail_ = nullptr;
+	unsigned cq_mask_ = 0;
+	io_uring_cqe* cqes_ = nullptr;
+
+	char* bufs_ = nullptr;
+
+	std::vector<peer_> peers_;
+	std::vector<write_que> wques_;
+	unique_fd_ wake_;
+	uint64_t wake_count_ = 0;
+	std::mutex dirty_mutex_;
+	std::unordered_set<int> dirty_;
+
+	std::thread thread_;
+	std::atomic_bool die_;
+
+	std::mutex recv_mutex_;
+	std::condition_variable recv_cv_;
+	std::list<message> mesgs_;
+};
+
+inline communicator* create_comm_tcp_uring( const char URI[], const bool quiet ){
+	tcp_mesh mesh = tcp_connect_mesh(URI);
+	const int remote_size = mesh.fds.size();
+
+	if( !quiet || mesh.rank == 0 )
+		std::cout << "MUI [comm_uring.h]: Identifier: " << URI << ", Domain size: " << mesh.size << ", Peers: " << remote_size << std::endl;
+
+	try {
+		return static_cast<communicator*>(new comm_uring(mesh.rank,mesh.size,mesh.fds));
+	}
+	catch( std::system_error& e ) {
+		std::cout << "MUI Warning [comm_uring.h]: " << e.what() << ", using the epoll backend" << std::endl;
+	}
+
+	std::vector<unique_fd_> r(remote_size);
+	for( int i = 0; i < remote_size; ++i ) r[i].reset(SYSCHECK(dup(mesh.fds[i])));
+	return static_cast<communicator*>(new comm_fd(mesh.rank,mesh.size,std::move(mesh.fds),std::move(r),mesh.opt.busy_poll,mesh.opt.timeout));
+}
+
+const static bool comm_tcp_uring_registered_ = comm_factory::instance().link( "tcp+uring", create_comm_tcp_uring );
+
+}
+
+#endif
@@ -0,0 +1,385 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+*****************************************************************************/
+
+/**
+ * @file codec.h
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Per-attribute frame codecs: XOR delta against the previous frame,
+ * byte-plane shuffling, zero-run or zlib compression and error-bounded
+ * quantisation of floating point values.
+ *
+ * The sender chooses a codec_config per attribute. Every encoded block
+ * records the stages that were applied to it, so a receiver decodes any
+ * block without prior configuration. Define MUI_USE_ZLIB (or enable the
+ * USE_ZLIB CMake option) to make codec_compression::zlib available.
+ */
+
+#ifndef MUI_CODEC_H_
+#define MUI_CODEC_H_
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#ifdef MUI_USE_ZLIB
+#include <zlib.h>
+#endif
+#include "../../general/util.h"
+#include "../../storage/stream.h"
+#include "../../storage/stream_vector.h"
+
+namespace mui {
+
+enum class codec_compression : std::uint8_t {
+	none = 0,   //- Store the bytes as they are
+	rle = 1,    //- Run-length encode zero bytes, cheap and effective after delta & shuffle
+	zlib = 2    //- Deflate, falls back to rle when built without MUI_USE_ZLIB
+};
+
+struct codec_config {
+	codec_config( bool delta_ = true, bool shuffle_ = true,
+	              codec_compression compression_ = codec_compression::rle, double error_bound_ = 0 )
+		: delta(delta_), shuffle(shuffle_), compression(compression_), error_bound(error_bound_) {}
+
+	bool delta;                    //- XOR against the previous frame of the same attribute
+	bool shuffle;                  //- Group the bytes of all elements by significance
+	codec_compression compression; //- Final entropy stage
+	double error_bound;            //- If > 0, floating point values are quantised to within this absolute error
+};
+
+// codec_layout: where the fixed width elements sit in a serialised attribute
+struct codec_layout {
+	std::uint32_t header = 0;       // bytes before the first element
+	std::uint32_t width = 0;        // bytes per element, 0 if elements have no fixed width
+	std::uint32_t value_offset = 0; // offset of the quantisable value inside an element
+	std::uint8_t value_kind = 0;    // 0: not quantisable, 1: float, 2: double
+};
+
+// codec_block: one encoded attribute of a frame
+struct codec_block {
+	enum : std::uint8_t { DELTA = 1, SHUFFLE = 2, QUANTISE = 4 };
+
+	std::uint8_t flags = 0;
+	std::uint8_t compression = 0;
+	codec_layout layout;
+	double step = 0;            // quantisation step
+	std::uint64_t raw_size = 0; // size of the serialised attribute
+	std::vector<char> bytes;
+};
+
+inline ostream& operator<<( ostream& stream, const codec_block& b )
+{
+	stream << b.flags << b.compression << b.layout.header << b.layout.width
+	       << b.layout.value_offset << b.layout.value_kind << b.step << b.raw_size << b.bytes;
+	return stream;
+}
+
+inline istream& operator>>( istream& stream, codec_block& b )
+{
+	stream >> b.flags >> b.compression >> b.layout.header >> b.layout.width
+	       >> b.layout.value_offset >> b.layout.value_kind >> b.step >> b.raw_size >> b.bytes;
+	return stream;
+}
+
+namespace codec {
+
+// element_: serialised width of an element type and position of its quantisable value
+template<typename T, typename = void> struct element_ {
+	static const std::uint32_t width = 0, value_offset = 0;
+	static const std::uint8_t value_kind = 0;
+};
+template<typename T> struct element_<T, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+	static const std::uint32_t width = sizeof(T), value_offset = 0;
+	static const std::uint8_t value_kind = std::is_same<T,float>::value ? 1 : std::is_same<T,double>::value ? 2 : 0;
+};
+template<typename T, uint D> struct element_<point<T,D>, typename std::enable_if<std::is_arithmetic<T>::value>::type> {
+	static const std::uint32_t width = D*sizeof(T), value_offset = 0;
+	static const std::uint8_t value_kind = 0; // locations are never quantised
+};
+template<typename A, typename B> struct element_<std::pair<A,B> > {
+	static const bool fixed = element_<A>::width != 0 && element_<B>::width != 0;
+	static const std::uint32_t width = fixed ? element_<A>::width + element_<B>::width : 0;
+	static const std::uint32_t value_offset = fixed ? element_<A>::width + element_<B>::value_offset : 0;
+	static const std::uint8_t value_kind = fixed ? element_<B>::value_kind : 0;
+};
+
+struct layout_ {
+	template<typename T> codec_layout operator()( const std::vector<T>& ) const {
+		codec_layout l;
+		l.header = sizeof(std::int32_t) + sizeof(std::size_t); // storage id & vector size
+		l.width = element_<T>::width;
+		l.value_offset = element_<T>::value_offset;
+		l.value_kind = element_<T>::value_kind;
+		return l;
+	}
+};
+
+inline void put_varint_( std::vector<char>& out, std::uint64_t v ) {
+	while( v >= 0x80u ) {
+		out.push_back(static_cast<char>((v & 0x7fu) | 0x80u));
+		v >>= 7;
+	}
+	out.push_back(static_cast<char>(v));
+}
+
+inline std::uint64_t get_varint_( const char*& p, const char* end ) {
+	std::uint64_t v = 0;
+	for( int s = 0; p != end && s < 64; s += 7 ) {
+		const std::uint8_t b = static_cast<std::uint8_t>(*p++);
+		v |= std::uint64_t(b & 0x7fu) << s;
+		if( !(b & 0x80u) ) return v;
+	}
+	throw std::runtime_error("MUI Error [codec.h]: Truncated codec stream.");
+}
+
+// rle_encode: alternating (literal count, literal bytes, zero count) runs
+inline std::vector<char> rle_encode( const std::vector<char>& in ) {
+	std::vector<char> out;
+	out.reserve(in.size()/4 + 16);
+	std::size_t i = 0;
+	while( i < in.size() ) {
+		std::size_t lit = i;
+		// a literal ends at the first run of at least two zero bytes
+		while( lit < in.size() && !(in[lit] == 0 && (lit+1 == in.size() || in[lit+1] == 0)) ) ++lit;
+		put_varint_(out, lit-i);
+		out.insert(out.end(), in.begin()+i, in.begin()+lit);
+		std::size_t zero = lit;
+		while( zero < in.size() && in[zero] == 0 ) ++zero;
+		put_varint_(out, zero-lit);
+		i = zero;
+	}
+	return out;
+}
+
+inline std::vector<char> rle_decode( const std::vector<char>& in, std::size_t size ) {
+	std::vector<char> out;
+	out.reserve(size);
+	const char* p = in.data();
+	const char* end = p + in.size();
+	while( p != end ) {
+		const std::uint64_t lit = get_varint_(p, end);
+		if( lit > static_cast<std::uint64_t>(end-p) || out.size()+lit > size )
+			throw std::runtime_error("MUI Error [codec.h]: Corrupt run-length stream.");
+		out.insert(out.end(), p, p+lit);
+		p += lit;
+		const std::uint64_t zero = get_varint_(p, end);
+		if( out.size()+zero > size ) throw std::runtime_error("MUI Error [codec.h]: Corrupt run-length stream.");
+		out.resize(out.size()+zero, 0);
+	}
+	if( out.size() != size ) throw std::runtime_error("MUI Error [codec.h]: Corrupt run-length stream.");
+	return out;
+}
+
+#ifdef MUI_USE_ZLIB
+inline std::vector<char> zlib_encode( const std::vector<char>& in ) {
+	uLongf n = compressBound(in.size());
+	std::vector<char> out(n);
+	if( compress2(reinterpret_cast<Bytef*>(out.data()), &n, reinterpret_cast<const Bytef*>(in.data()), in.size(), Z_BEST_SPEED) != Z_OK )
+		throw std::runtime_error("MUI Error [codec.h]: zlib compression failed.");
+	out.resize(n);
+	return out;
+}
+
+inline std::vector<char> zlib_decode( const std::vector<char>& in, std::size_t size ) {
+	std::vector<char> out(size);
+	uLongf n = size;
+	if( uncompress(reinterpret_cast<Bytef*>(out.data()), &n, reinterpret_cast<const Bytef*>(in.data()), in.size()) != Z_OK || n != size )
+		throw std::runtime_error("MUI Error [codec.h]: zlib decompression failed.");
+	return out;
+}
+#endif
+
+// shuffle: element-major to byte-plane-major over the elements of a layout
+inline void shuffle( std::vector<char>& buf, const codec_layout& l ) {
+	const std::size_t n = (buf.size() - l.header) / l.width;
+	std::vector<char> tmp(n*l.width);
+	const char* src = buf.data() + l.header;
+	for( std::size_t i=0; i<n; ++i )
+		for( std::size_t b=0; b<l.width; ++b ) tmp[b*n+i] = src[i*l.width+b];
+	std::copy(tmp.begin(), tmp.end(), buf.begin()+l.header);
+}
+
+inline void unshuffle( std::vector<char>& buf, const codec_layout& l ) {
+	const std::size_t n = (buf.size() - l.header) / l.width;
+	std::vector<char> tmp(n*l.width);
+	const char* src = buf.data() + l.header;
+	for( std::size_t b=0; b<l.width; ++b )
+		for( std::size_t i=0; i<n; ++i ) tmp[i*l.width+b] = src[b*n+i];
+	std::copy(tmp.begin(), tmp.end(), buf.begin()+l.header);
+}
+
+// quantise: replaces every float/double value by the integer code of the same width,
+// round(value/step). Returns false, leaving buf untouched, if any value has no code.
+template<typename REAL, typename CODE>
+inline bool quantise_( std::vector<char>& buf, const codec_layout& l, double step ) {
+	const std::size_t n = (buf.size() - l.header) / l.width;
+	const double limit = static_cast<double>(std::numeric_limits<CODE>::max());
+	std::vector<CODE> codes(n);
+	for( std::size_t i=0; i<n; ++i ) {
+		auto in = make_istream(buf.data() + l.header + i*l.width + l.value_offset);
+		REAL v;
+		in >> v;
+		const double q = std::round(static_cast<double>(v)/step);
+		if( !(std::abs(q) < limit) ) return false; // also rejects nan & inf
+		codes[i] = static_cast<CODE>(q);
+	}
+	for( std::size_t i=0; i<n; ++i ) {
+		auto out = make_ostream(buf.data() + l.header + i*l.width + l.value_offset);
+		out << codes[i];
+	}
+	return true;
+}
+
+template<typename REAL, typename CODE>
+inline void dequantise_( std::vector<char>& buf, const codec_layout& l, double step ) {
+	const std::size_t n = (buf.size() - l.header) / l.width;
+	for( std::size_t i=0; i<n; ++i ) {
+		char* p = buf.data() + l.header + i*l.width + l.value_offset;
+		auto in = make_istream(p);
+		CODE q;
+		in >> q;
+		auto out = make_ostream(p);
+		out << static_cast<REAL>(static_cast<double>(q)*step);
+	}
+}
+
+// state: reference frame of every attribute. The sender and each receiver keep one
+// and apply the same blocks in the same order, so their references stay identical.
+class state {
+public:
+	template<typename STORAGE>
+	codec_block encode( const std::string& attr, const STORAGE& st, const codec_config& cfg ) {
+		codec_block b;
+		b.layout = st.apply_visitor(layout_());
+
+		std::vector<char> buf(streamed_size(st));
+		auto out = make_ostream(buf.data());
+		out << st;
+		b.raw_size = buf.size();
+
+		const bool fixed = b.layout.width != 0 && buf.size() >= b.layout.header;
+		if( fixed && cfg.error_bound > 0 && b.layout.value_kind != 0 ) {
+			b.step = 2*cfg.error_bound;
+			const bool ok = b.layout.value_kind == 1 ? quantise_<float,std::int32_t>(buf, b.layout, b.step)
+			                                         : quantise_<double,std::int64_t>(buf, b.layout, b.step);
+			if( ok ) b.flags |= codec_block::QUANTISE;
+		}
+
+		if( cfg.delta ) {
+			std::vector<char>& ref = ref_[attr];
+			std::vector<char> cur(buf);
+			if( ref.size() == buf.size() ) {
+				for( std::size_t i=0; i<buf.size(); ++i ) buf[i] ^= ref[i];
+				b.flags |= codec_block::DELTA;
+			}
+			ref.swap(cur);
+		}
+		else ref_.erase(attr);
+
+		if( fixed && cfg.shuffle && b.layout.width > 1 ) {
+			shuffle(buf, b.layout);
+			b.flags |= codec_block::SHUFFLE;
+		}
+
+		switch( cfg.compression ) {
+#ifdef MUI_USE_ZLIB
+		case codec_compression::zlib:
+			b.bytes = zlib_encode(buf);
+			b.compression = static_cast<std::uint8_t>(codec_compression::zlib);
+			break;
+#else
+		case codec_compression::zlib:
+#endif
+		case codec_compression::rle:
+			b.bytes = rle_encode(buf);
+			b.compression = static_cast<std::uint8_t>(codec_compression::rle);
+			break;
+		default:
+			b.bytes.swap(buf);
+		}
+		return b;
+	}
+
+	template<typename STORAGE>
+	STORAGE decode( const std::string& attr, const codec_block& b ) {
+		std::vector<char> buf;
+		switch( static_cast<codec_compression>(b.compression) ) {
+		case codec_compression::none: buf = b.bytes; break;
+		case codec_compression::rle:  buf = rle_decode(b.bytes, b.raw_size); break;
+#ifdef MUI_USE_ZLIB
+		case codec_compression::zlib: buf = zlib_decode(b.bytes, b.raw_size); break;
+#endif
+		default: throw std::runtime_error("MUI Error [codec.h]: Unsupported compression, rebuild with MUI_USE_ZLIB.");
+		}
+		if( buf.size() != b.raw_size ) throw std::runtime_error("MUI Error [codec.h]: Frame size mismatch.");
+
+		if( b.flags & codec_block::SHUFFLE ) unshuffle(buf, b.layout);
+
+		if( b.flags & codec_block::DELTA ) {
+			auto itr = ref_.find(attr);
+			if( itr == ref_.end() || itr->second.size() != buf.size() )
+				throw std::runtime_error("MUI Error [codec.h]: Delta frame received without its reference frame.");
+			for( std::size_t i=0; i<buf.size(); ++i ) buf[i] ^= itr->second[i];
+			itr->second = buf;
+		}
+		else ref_[attr] = buf;
+
+		if( b.flags & codec_block::QUANTISE ) {
+			if( b.layout.value_kind == 1 ) dequantise_<float,std::int32_t>(buf, b.layout, b.step);
+			else dequantise_<double,std::int64_t>(buf, b.layout, b.step);
+		}
+
+		STORAGE st;
+		auto in = make_istream(buf.begin());
+		in >> st;
+		return st;
+	}
+
+	// forget every reference frame, the next block of each attribute is a key frame
+	void reset() { ref_.clear(); }
+private:
+	std::unordered_map<std::string, std::vector<char> > ref_;
+};
+
+}
+}
+
+#endif /* MUI_CODEC_H_ */
@@ -49,6 +49,8 @@
 #define MESSAGE_H_
 
 #include <memory>
+#include <tuple>
+#include <typeinfo>
 #include "../../general/util.h"
 #include "../../storage/stream.h"
 #include "../../storage/stream_string.h"
@@ -62,9 +64,36 @@ struct message
 public:
 	using id_type = std::string;
 private:
+	// arguments of a message made by make_lazy(), kept as objects until the bytes are needed
+	struct holder_base_ {
+		virtual ~holder_base_() {}
+		virtual std::size_t size() const = 0;
+		virtual void write( ostream& stream ) const = 0;
+		virtual const std::type_info& type() const = 0;
+	};
+	template<typename T>
+	struct holder_: holder_base_ {
+		template<typename... types>
+		explicit holder_( types&&... data ) : value(std::forward<types>(data)...) {}
+		std::size_t size() const { return streamed_size(value); }
+		void write( ostream& stream ) const { stream << value; }
+		const std::type_info& type() const { return typeid(T); }
+		T value;
+	};
+
         id_type     id_;
         std::size_t id_size_;
-        std::vector<char> data_;
+        mutable std::vector<char> data_;
+        mutable std::shared_ptr<holder_base_> payload_;
+
+	void serialize_() const {
+		if( !payload_ ) return;
+		data_.resize(id_size_ + payload_->size());
+		auto stream = make_ostream(data_.data());
+		stream << id_;
+		payload_->write(stream);
+		payload_.reset();
+	}
 public:
 	message() : id_(), id_size_(0u), data_() {}
 
@@ -79,6 +108,16 @@ public:
 		stream << id << std::forward_as_tuple(data...);
 		return msg;
 	}
+	// as make(), but serialises only when the bytes are first asked for, so that
+	// in-process communicators can hand the arguments over as they are
+	template<typename... types>
+	static message make_lazy( const id_type& id, types&&... data ) {
+		message msg;
+		msg.id_ = id;
+		msg.id_size_ = streamed_size(id);
+		msg.payload_ = std::make_shared<holder_<std::tuple<typename std::decay<types>::type...> > >(std::forward<types>(data)...);
+		return msg;
+	}
 	static message make( std::vector<char> data ){
 		message m;
 		m.data_.swap(data);
@@ -91,9 +130,16 @@ public:
 	bool has_id() const { return !id_.empty(); }
 
 	const id_type& id() const { return id_; }
-	const char* data() const { return data_.data() + id_size_; }
-	std::size_t size() const { return data_.size() - id_size_; }
+	const char* data() const { serialize_(); return data_.data() + id_size_; }
+	std::size_t size() const { serialize_(); return data_.size() - id_size_; }
+	// the unserialised arguments if they are a T held by this message alone, else nullptr
+	template<typename T>
+	T* payload() {
+		if( !payload_ || payload_.use_count() != 1 || payload_->type() != typeid(T) ) return nullptr;
+		return &static_cast<holder_<T>*>(payload_.get())->value;
+	}
 	std::vector<char> detach() {
+		serialize_();
 		std::vector<char> data;
 		data.swap(data_);
 		id_.clear();
@@ -107,6 +153,7 @@ private:
 // serialization & deserialization method
 inline ostream& operator<< ( ostream& stream, const message& m )
 {
+	m.serialize_();
 	stream << m.data_;
 	return stream;
 }
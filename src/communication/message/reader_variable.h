@@ -67,7 +67,10 @@ struct reader_variables {
 
 	reader_variables() = default;
 	reader_variables( function_type f ) : f_(std::move(f)) {}
-	void operator()( const message& msg ){
+	void operator()( message msg ){
+		// arguments handed over in-process are used as they are
+		if( tuple_type* p = msg.template payload<tuple_type>() )
+			return apply(*p, typename make_index_sequence<sizeof...(Args)>::type());
 		// parse msg as tuple of variables
 		auto stream = make_istream(msg.data());
 		tuple_type t;
@@ -65,6 +65,7 @@ struct one_dim {
 	static const bool QUIET = false;			//- If the library is quiet then it will only issue critical warning messages
 
 	using REAL = double;						//- REAL data type
+	using ACCUM = REAL;							//- Type samplers accumulate weights and sums in, may be wider than REAL
 	using INT = int;							//- INT data type
 
 	using time_type = REAL;						//- INT for iteration coupling, REAL for time-based coupling
@@ -90,6 +91,7 @@ struct two_dim {
 	static const bool QUIET = false;
 
 	using REAL = double;
+	using ACCUM = REAL;
 	using INT  = int;
 
 	using time_type = REAL;
@@ -115,6 +117,7 @@ struct three_dim {
 	static const bool QUIET = false;
 
 	using REAL = double;
+	using ACCUM = REAL;
 	using INT  = int;
 
 	using time_type = REAL;
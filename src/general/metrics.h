@@ -0,0 +1,313 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+******************************************************************************/
+
+
+/**
+ * @file metrics.h
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Counters and timers for the hot paths of uniface and the
+ * communicators. Recording is compiled in only when MUI_METRICS is defined,
+ * otherwise every record call is an empty inline function.
+ *
+ * Timers are a fixed set of ids with atomic totals, so timing a scope takes
+ * no lock. Only the coarse timers (one per barrier, build or message) are
+ * kept as trace events; sampler time is summed only.
+ */
+
+#ifndef MUI_METRICS_H_
+#define MUI_METRICS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mui {
+
+// Upper bound on the events kept for chrome_trace(), later events only update the totals
+#ifndef MUI_METRICS_TRACE_LIMIT
+#define MUI_METRICS_TRACE_LIMIT 65536
+#endif
+
+class metrics {
+public:
+	using clock = std::chrono::steady_clock;
+
+	struct peer_stats {
+		std::uint64_t bytes_sent = 0;
+		std::uint64_t bytes_recv = 0;
+		std::uint64_t msgs_sent = 0;
+		std::uint64_t msgs_recv = 0;
+	};
+	struct message_stats {
+		std::uint64_t sent = 0;
+		std::uint64_t received = 0;
+	};
+	struct timer_stats {
+		std::uint64_t count = 0;
+		double total = 0; // seconds
+		double max = 0;   // seconds
+	};
+
+	enum timer_id { BIN_BUILD, SAMPLER, BARRIER, BARRIER_SS, SERIALISE, DESERIALISE, TIMERS };
+
+	static const char* name( timer_id id ) {
+		static const char* const names[TIMERS] = { "bin_build", "sampler", "barrier", "barrier_ss", "serialise", "deserialise" };
+		return names[id];
+	}
+
+	// Times the enclosing scope under the given id
+	class timer {
+	public:
+#ifdef MUI_METRICS
+		timer( metrics* m, timer_id id ) : m_(m), id_(id), start_(clock::now()) {}
+		~timer() { if( m_ ) m_->time(id_, start_, clock::now()); }
+	private:
+		metrics* m_;
+		timer_id id_;
+		clock::time_point start_;
+#else
+		timer( metrics*, timer_id ) {}
+#endif
+		timer( const timer& ) = delete;
+		timer& operator=( const timer& ) = delete;
+	};
+
+	metrics() : epoch_(clock::now()) {
+		clear_timers_();
+	}
+
+	static constexpr bool enabled() {
+#ifdef MUI_METRICS
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	// process id written to chrome_trace(), usually the local rank
+	void set_pid( int pid ) { pid_ = pid; }
+
+#ifdef MUI_METRICS
+	void sent( int peer, std::size_t bytes ) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		peer_stats& p = peers_[peer];
+		p.bytes_sent += bytes;
+		p.msgs_sent++;
+	}
+	void received( int peer, std::size_t bytes ) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		peer_stats& p = peers_[peer];
+		p.bytes_recv += bytes;
+		p.msgs_recv++;
+	}
+	void message_sent( const std::string& id ) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		messages_[id].sent++;
+	}
+	void message_received( const std::string& id ) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		messages_[id].received++;
+	}
+	void time( timer_id id, clock::time_point start, clock::time_point end ) {
+		const std::uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+		timer_& t = timers_[id];
+		t.count.fetch_add(1, std::memory_order_relaxed);
+		t.total.fetch_add(ns, std::memory_order_relaxed);
+		std::uint64_t max = t.max.load(std::memory_order_relaxed);
+		while( ns > max && !t.max.compare_exchange_weak(max, ns, std::memory_order_relaxed) ) {}
+		if( id == SAMPLER ) return; // once per fetched point, too many to trace
+		std::lock_guard<std::mutex> lock(mutex_);
+		if( events_.size() < MUI_METRICS_TRACE_LIMIT )
+			events_.push_back(event_{name(id), start, end, thread_index_()});
+	}
+#else
+	void sent( int, std::size_t ) {}
+	void received( int, std::size_t ) {}
+	void message_sent( const std::string& ) {}
+	void message_received( const std::string& ) {}
+	void time( timer_id, clock::time_point, clock::time_point ) {}
+#endif
+
+	/** \brief Bytes and messages exchanged with each remote rank
+	*/
+	std::map<int, peer_stats> peers() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return peers_;
+	}
+
+	/** \brief Messages sent and received of each id
+	*/
+	std::map<std::string, message_stats> messages() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return messages_;
+	}
+
+	/** \brief Count, total and longest duration of each timer
+	*/
+	std::map<std::string, timer_stats> timers() const {
+		std::map<std::string, timer_stats> ret;
+		for( int i = 0; i < TIMERS; ++i ) {
+			const timer_& t = timers_[i];
+			if( !t.count.load() ) continue;
+			timer_stats& s = ret[name(timer_id(i))];
+			s.count = t.count.load();
+			s.total = t.total.load()*1e-9;
+			s.max = t.max.load()*1e-9;
+		}
+		return ret;
+	}
+
+	void reset() {
+		std::lock_guard<std::mutex> lock(mutex_);
+		peers_.clear();
+		messages_.clear();
+		clear_timers_();
+		events_.clear();
+		epoch_ = clock::now();
+	}
+
+	/** \brief All counters and timer totals as one JSON object
+	*/
+	std::string json() const {
+		const std::map<std::string, timer_stats> timers = this->timers();
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::ostringstream out;
+		out.precision(9);
+		out << "{\"peers\":{";
+		for( auto i = peers_.begin(); i != peers_.end(); ++i ) {
+			if( i != peers_.begin() ) out << ',';
+			out << '"' << i->first << "\":{\"bytes_sent\":" << i->second.bytes_sent
+			    << ",\"bytes_recv\":" << i->second.bytes_recv
+			    << ",\"msgs_sent\":" << i->second.msgs_sent
+			    << ",\"msgs_recv\":" << i->second.msgs_recv << '}';
+		}
+		out << "},\"messages\":{";
+		for( auto i = messages_.begin(); i != messages_.end(); ++i ) {
+			if( i != messages_.begin() ) out << ',';
+			out << quote_(i->first) << ":{\"sent\":" << i->second.sent
+			    << ",\"received\":" << i->second.received << '}';
+		}
+		out << "},\"timers\":{";
+		for( auto i = timers.begin(); i != timers.end(); ++i ) {
+			if( i != timers.begin() ) out << ',';
+			out << quote_(i->first) << ":{\"count\":" << i->second.count
+			    << ",\"total\":" << i->second.total
+			    << ",\"max\":" << i->second.max << '}';
+		}
+		out << "}}";
+		return out.str();
+	}
+
+	/** \brief Timed scopes as complete events of the Chrome trace event format,
+	* viewable in chrome://tracing or Perfetto
+	*/
+	std::string chrome_trace() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		std::ostringstream out;
+		out.setf(std::ios::fixed);
+		out.precision(3);
+		out << "{\"traceEvents\":[";
+		for( std::size_t i = 0; i < events_.size(); ++i ) {
+			const event_& e = events_[i];
+			if( i ) out << ',';
+			out << "{\"name\":" << quote_(e.name) << ",\"ph\":\"X\",\"pid\":" << pid_ << ",\"tid\":" << e.tid
+			    << ",\"ts\":" << std::chrono::duration<double, std::micro>(e.start - epoch_).count()
+			    << ",\"dur\":" << std::chrono::duration<double, std::micro>(e.end - e.start).count() << '}';
+		}
+		out << "],\"displayTimeUnit\":\"ms\"}";
+		return out.str();
+	}
+
+private:
+	struct timer_ {
+		std::atomic<std::uint64_t> count;
+		std::atomic<std::uint64_t> total; // nanoseconds
+		std::atomic<std::uint64_t> max;   // nanoseconds
+	};
+	struct event_ {
+		const char* name;
+		clock::time_point start;
+		clock::time_point end;
+		int tid;
+	};
+
+	void clear_timers_() {
+		for( timer_& t: timers_ ) {
+			t.count.store(0);
+			t.total.store(0);
+			t.max.store(0);
+		}
+	}
+
+	// small stable index of the calling thread, called with mutex_ held
+	int thread_index_() {
+		auto i = threads_.insert(std::make_pair(std::this_thread::get_id(), int(threads_.size())));
+		return i.first->second;
+	}
+
+	static std::string quote_( const std::string& s ) {
+		std::string r("\"");
+		for( char c: s ) {
+			if( c == '"' || c == '\\' ) r += '\\';
+			if( static_cast<unsigned char>(c) < 0x20 ) r += ' ';
+			else r += c;
+		}
+		return r += '"';
+	}
+
+	mutable std::mutex mutex_;
+	std::map<int, peer_stats> peers_;
+	std::map<std::string, message_stats> messages_;
+	timer_ timers_[TIMERS];
+	std::vector<event_> events_;
+	std::map<std::thread::id, int> threads_;
+	clock::time_point epoch_;
+	int pid_ = 0;
+};
+
+}
+
+#endif /* MUI_METRICS_H_ */
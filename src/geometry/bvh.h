@@ -0,0 +1,168 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+******************************************************************************/
+
+/**
+ * @file bvh.h
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Bounding volume hierarchy over axis-aligned boxes, used to find
+ * which peers' spans can meet a local span without testing every peer.
+ */
+
+#ifndef MUI_BVH_H
+#define MUI_BVH_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "geometry.h"
+
+namespace mui {
+namespace geometry {
+
+/* bvh
+ * Static tree over (box, payload) items, built top-down by median split of the
+ * box centres along their widest axis. Boxes may be unbounded.
+ */
+template<typename CONFIG>
+class bvh {
+	using REAL = typename CONFIG::REAL;
+	using item_type = std::pair<box<CONFIG>, std::size_t>;
+
+	static const std::size_t LEAF = 4; // items per leaf
+
+	struct node_ {
+		box<CONFIG> bx;
+		std::size_t first; // leaf: first item; inner: index of the right child, the left child follows
+		std::size_t count; // leaf: number of items; inner: 0
+	};
+public:
+	void build( std::vector<item_type> items ) {
+		items_.swap(items);
+		nodes_.clear();
+		if( !items_.empty() ) build_(0, items_.size());
+	}
+	void clear() {
+		items_.clear();
+		nodes_.clear();
+	}
+	bool empty() const { return items_.empty(); }
+
+	// calls f(payload) for every item whose box meets q
+	template<typename F>
+	void query( const box<CONFIG>& q, F f ) const {
+		if( nodes_.empty() ) return;
+		std::vector<std::size_t> stack(1, 0);
+		while( !stack.empty() ) {
+			const node_& n = nodes_[stack.back()];
+			const std::size_t self = stack.back();
+			stack.pop_back();
+			if( !collide(n.bx, q) ) continue;
+			if( n.count ) {
+				for( std::size_t i = n.first; i < n.first + n.count; ++i )
+					if( collide(items_[i].first, q) ) f(items_[i].second);
+			}
+			else {
+				stack.push_back(n.first);
+				stack.push_back(self + 1);
+			}
+		}
+	}
+
+private:
+	// a finite stand-in for the centre of a box along d, so that unbounded boxes still sort
+	static REAL centre_( const box<CONFIG>& b, std::size_t d ) {
+		const REAL lo = b.get_min()[d], hi = b.get_max()[d];
+		const bool flo = std::abs(lo) <= std::numeric_limits<REAL>::max();
+		const bool fhi = std::abs(hi) <= std::numeric_limits<REAL>::max();
+		if( flo && fhi ) return lo/2 + hi/2;
+		if( flo ) return lo;
+		if( fhi ) return hi;
+		return 0;
+	}
+
+	std::size_t build_( std::size_t first, std::size_t last ) {
+		const std::size_t self = nodes_.size();
+		nodes_.emplace_back();
+
+		box<CONFIG> bx = items_[first].first;
+		REAL cmin[CONFIG::D], cmax[CONFIG::D];
+		for( std::size_t d = 0; d < CONFIG::D; ++d ) cmin[d] = cmax[d] = centre_(items_[first].first, d);
+		for( std::size_t i = first+1; i < last; ++i ) {
+			for( std::size_t d = 0; d < CONFIG::D; ++d ) {
+				bx.get_min()[d] = std::min(bx.get_min()[d], items_[i].first.get_min()[d]);
+				bx.get_max()[d] = std::max(bx.get_max()[d], items_[i].first.get_max()[d]);
+				const REAL c = centre_(items_[i].first, d);
+				cmin[d] = std::min(cmin[d], c);
+				cmax[d] = std::max(cmax[d], c);
+			}
+		}
+		nodes_[self].bx = bx;
+
+		if( last - first <= LEAF ) {
+			nodes_[self].first = first;
+			nodes_[self].count = last - first;
+			return self;
+		}
+
+		std::size_t axis = 0;
+		for( std::size_t d = 1; d < CONFIG::D; ++d )
+			if( cmax[d] - cmin[d] > cmax[axis] - cmin[axis] ) axis = d;
+		const std::size_t mid = first + (last - first)/2;
+		std::nth_element(items_.begin()+first, items_.begin()+mid, items_.begin()+last,
+		                 [axis](const item_type& a, const item_type& b) { return centre_(a.first, axis) < centre_(b.first, axis); });
+
+		build_(first, mid);
+		const std::size_t right = build_(mid, last);
+		nodes_[self].first = right;
+		nodes_[self].count = 0;
+		return self;
+	}
+
+	std::vector<node_> nodes_;
+	std::vector<item_type> items_;
+};
+
+}
+}
+
+#endif
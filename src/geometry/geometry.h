@@ -48,7 +48,10 @@
 #ifndef MUI_GEOMETRY_H
 #define MUI_GEOMETRY_H
 
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <vector>
 
 #include "../config.h"
 #include "../storage/stream.h"
@@ -88,48 +91,197 @@ public:
 	virtual void deserialize(istream& stream) = 0;
 };
 
+/* any_shape
+ * A shape held by value as flat arrays of its parts: boxes as one array per
+ * bound and dimension, points and spheres as balls. An or_set is the union of
+ * its parts, so collide() is a static test of each part of one side against
+ * the arrays of the other, with no virtual call and no recursion. Empty is
+ * the universe.
+ */
 template<typename CONFIG>
 class any_shape {
+	using coordinate_type = typename CONFIG::point_type;
+	using REAL = typename CONFIG::REAL;
+
+	static const std::size_t BLOCK = 16; // boxes tested between early exits
+
+	struct ball_ {
+		shape_type type; // point or sphere
+		coordinate_type center;
+		REAL radius;
+	};
 public:
 	any_shape() = default;
-	any_shape( const any_shape& rhs )
-		: content(rhs.content ? rhs.content->clone() : 0) {}
+	any_shape( const any_shape& ) = default;
 	any_shape( any_shape&& ) noexcept = default;
-	any_shape( const shape<CONFIG>& rhs ) : content(rhs.clone()) {}
+	any_shape( const shape<CONFIG>& rhs ) : universe_(false) { add_(rhs); }
 	any_shape& operator=( any_shape rhs ){
 		rhs.swap(*this);
 		return *this;
 	}
 
-	explicit operator bool() const noexcept { return static_cast<bool>(content); }
-	bool empty() const noexcept { return !static_cast<bool>(content); }
-	void swap( any_shape& rhs ) noexcept { content.swap(rhs.content); }
+	explicit operator bool() const noexcept { return !universe_; }
+	bool empty() const noexcept { return universe_; }
+	void swap( any_shape& rhs ) noexcept {
+		std::swap(universe_, rhs.universe_);
+		balls_.swap(rhs.balls_);
+		for( uint i = 0; i < CONFIG::D; ++i ) {
+			min_[i].swap(rhs.min_[i]);
+			max_[i].swap(rhs.max_[i]);
+		}
+	}
 
-	shape<CONFIG>& get() { return *content; }
-	const shape<CONFIG>& get() const { return *content; }
-	
-	shape_type type() const noexcept { return content ? content->type() : shape_type::universe;  }
+	shape_type type() const noexcept {
+		if( universe_ ) return shape_type::universe;
+		if( balls_.size() + boxes_() != 1 ) return shape_type::or_set;
+		return balls_.empty() ? shape_type::box : balls_[0].type;
+	}
 	box<CONFIG> bbox() const;
 
+	// true if any part of this meets any part of rhs
+	bool collide( const any_shape& rhs ) const {
+		if( universe_ || rhs.universe_ ) return true;
+		// walk the parts of the smaller side against the arrays of the larger
+		if( balls_.size() + boxes_() > rhs.balls_.size() + rhs.boxes_() ) return rhs.collide(*this);
+		coordinate_type lo, hi;
+		for( std::size_t i = 0; i < boxes_(); ++i ) {
+			for( uint d = 0; d < CONFIG::D; ++d ) {
+				lo[d] = min_[d][i];
+				hi[d] = max_[d][i];
+			}
+			if( rhs.meets_box_(lo, hi) ) return true;
+		}
+		for( const ball_& b: balls_ )
+			if( rhs.meets_ball_(b.center, b.radius) ) return true;
+		return false;
+	}
+
 	friend ostream& operator<<(ostream& stream, const any_shape& obj){
-		stream << static_cast<std::int8_t>(obj.type());
-		if( !obj.empty() ) obj.get().serialize(stream);
+		if( obj.universe_ ) return stream << static_cast<std::int8_t>(shape_type::universe);
+		// parts as the chain or_set(part, or_set(part, ... part))
+		const std::size_t n = obj.boxes_() + obj.balls_.size();
+		for( std::size_t k = 0; k < n; ++k ) {
+			if( k + 1 < n ) stream << static_cast<std::int8_t>(shape_type::or_set);
+			if( k < obj.boxes_() ) {
+				coordinate_type lo, hi;
+				for( uint d = 0; d < CONFIG::D; ++d ) {
+					lo[d] = obj.min_[d][k];
+					hi[d] = obj.max_[d][k];
+				}
+				stream << static_cast<std::int8_t>(shape_type::box) << lo << hi;
+			}
+			else {
+				const ball_& b = obj.balls_[k - obj.boxes_()];
+				stream << static_cast<std::int8_t>(b.type) << b.center;
+				if( b.type == shape_type::sphere ) stream << b.radius;
+			}
+		}
 		return stream;
 	}
 	friend istream& operator>>(istream& stream, any_shape& obj){
+		any_shape tmp;
+		tmp.universe_ = false;
+		tmp.read_(stream);
+		obj.swap(tmp);
+		return stream;
+	}
+
+private:
+	std::size_t boxes_() const { return min_[0].size(); }
+
+	void add_( const shape<CONFIG>& rhs );
+	void add_( const any_shape& rhs ) {
+		if( universe_ ) return;
+		if( rhs.universe_ ) {
+			any_shape().swap(*this);
+			return;
+		}
+		balls_.insert(balls_.end(), rhs.balls_.begin(), rhs.balls_.end());
+		for( uint d = 0; d < CONFIG::D; ++d ) {
+			min_[d].insert(min_[d].end(), rhs.min_[d].begin(), rhs.min_[d].end());
+			max_[d].insert(max_[d].end(), rhs.max_[d].begin(), rhs.max_[d].end());
+		}
+	}
+	void add_box_( const coordinate_type& lo, const coordinate_type& hi ) {
+		if( universe_ ) return;
+		for( uint d = 0; d < CONFIG::D; ++d ) {
+			min_[d].push_back(lo[d]);
+			max_[d].push_back(hi[d]);
+		}
+	}
+	void add_ball_( shape_type type, const coordinate_type& center, REAL radius ) {
+		if( universe_ ) return;
+		balls_.push_back(ball_{type, center, radius});
+	}
+
+	void read_( istream& stream ) {
 		std::int8_t tp;
 		stream >> tp;
-		if( static_cast<shape_type>(tp) == shape_type::universe ) obj = any_shape();
-		else {
-			auto tmp = shape_factory<CONFIG>(static_cast<shape_type>(tp));
-			tmp->deserialize(stream);
-			obj.content.swap(tmp);
+		coordinate_type a, b;
+		REAL r;
+		switch( static_cast<shape_type>(tp) ) {
+		case shape_type::universe: any_shape().swap(*this); break;
+		case shape_type::or_set: read_(stream); read_(stream); break;
+		case shape_type::point: stream >> a; add_ball_(shape_type::point, a, REAL(0)); break;
+		case shape_type::sphere: stream >> a >> r; add_ball_(shape_type::sphere, a, r); break;
+		case shape_type::box: stream >> a >> b; add_box_(a, b); break;
 		}
-		return stream;
 	}
-	
-private:
-	std::unique_ptr<shape<CONFIG> > content;
+
+	// true if any part meets the box [lo, hi]
+	bool meets_box_( const coordinate_type& lo, const coordinate_type& hi ) const {
+		const std::size_t n = boxes_();
+		for( std::size_t i0 = 0; i0 < n; i0 += BLOCK ) {
+			const std::size_t i1 = std::min(n, i0 + BLOCK);
+			int hit = 0;
+			// branch free over a block so that the loop vectorises
+			for( std::size_t i = i0; i < i1; ++i ) {
+				int in = 1;
+				for( uint d = 0; d < CONFIG::D; ++d ) in &= (min_[d][i] <= hi[d]) & (lo[d] <= max_[d][i]);
+				hit |= in;
+			}
+			if( hit ) return true;
+		}
+		for( const ball_& b: balls_ )
+			if( distsq_(b.center, lo, hi) <= b.radius*b.radius ) return true;
+		return false;
+	}
+
+	// true if any part meets the ball of radius r around c
+	bool meets_ball_( const coordinate_type& c, REAL r ) const {
+		const REAL rr = r*r;
+		const std::size_t n = boxes_();
+		for( std::size_t i0 = 0; i0 < n; i0 += BLOCK ) {
+			const std::size_t i1 = std::min(n, i0 + BLOCK);
+			int hit = 0;
+			for( std::size_t i = i0; i < i1; ++i ) {
+				REAL dist = 0;
+				for( uint d = 0; d < CONFIG::D; ++d ) {
+					const REAL e = std::max(std::max(min_[d][i] - c[d], c[d] - max_[d][i]), REAL(0));
+					dist += e*e;
+				}
+				hit |= (dist <= rr);
+			}
+			if( hit ) return true;
+		}
+		for( const ball_& b: balls_ )
+			if( normsq(c - b.center) <= (r + b.radius)*(r + b.radius) ) return true;
+		return false;
+	}
+
+	// squared distance from c to the box [lo, hi]
+	static REAL distsq_( const coordinate_type& c, const coordinate_type& lo, const coordinate_type& hi ) {
+		REAL dist = 0;
+		for( uint d = 0; d < CONFIG::D; ++d ) {
+			const REAL e = std::max(std::max(lo[d] - c[d], c[d] - hi[d]), REAL(0));
+			dist += e*e;
+		}
+		return dist;
+	}
+
+	bool universe_ = true;
+	std::vector<ball_> balls_;
+	std::vector<REAL> min_[CONFIG::D], max_[CONFIG::D]; // boxes, one array per bound and dimension
 };
 template<typename CONFIG> any_shape<CONFIG> get_universe_set() { return any_shape<CONFIG>(); }
 
@@ -226,7 +378,7 @@ class or_set: public shape<CONFIG> {
 	typedef typename CONFIG::REAL REAL;
 public:
 	or_set() = default;
-	or_set(any_shape<CONFIG> obj1, any_shape<CONFIG>& obj2): lhs_(std::move(obj1)), rhs_(std::move(obj2)) {}
+	or_set(any_shape<CONFIG> obj1, any_shape<CONFIG> obj2): lhs_(std::move(obj1)), rhs_(std::move(obj2)) {}
 
 	const any_shape<CONFIG>& left() const { return lhs_; }
 	any_shape<CONFIG>& left() { return lhs_; }
@@ -262,65 +414,26 @@ template<typename CONFIG> std::unique_ptr<shape<CONFIG> > shape_factory(shape_ty
 	return std::unique_ptr<shape<CONFIG> >(ptr);
 }
 
-namespace {
-#define CASE(LHS, RHS) case shape_type::RHS : \
-	return collide(static_cast<const LHS<CONFIG>&>(lhs), static_cast<const RHS<CONFIG>&>(rhs))
-template<typename CONFIG> bool collide_impl_(const shape<CONFIG>& lhs, const shape<CONFIG>& rhs)
+template<typename CONFIG> bool collide( const any_shape<CONFIG>& lhs, const any_shape<CONFIG>& rhs)
 {
-	switch(lhs.type()){
-	case shape_type::universe:
-		return true;
-	case shape_type::or_set : {
-		auto& obj = static_cast<const or_set<CONFIG>&>(lhs);
-		return collide(obj.left(),rhs) || collide(obj.right(),rhs);
-	}
-	case shape_type::point :
-		switch(rhs.type()){
-		CASE(point,point);
-		CASE(point,sphere);
-		CASE(point,box);
-		default: return true;
-		}
-	case shape_type::sphere :
-		switch(rhs.type()){
-		CASE(sphere,sphere);
-		CASE(sphere,box);
-		default: return true;
-		}
-	case shape_type::box :
-		switch(rhs.type()){
-		CASE(box,box);
-		default: return true;
-		}
-	}
-	return true; // cannot reach here
-}
-#undef CASE
+	return lhs.collide(rhs);
 }
 
 template<typename CONFIG> bool collide( const shape<CONFIG>& lhs, const shape<CONFIG>& rhs)
 {
-	return static_cast<std::int8_t>(lhs.type()) <= static_cast<std::int8_t>(rhs.type()) ?
-		collide_impl_(lhs,rhs):
-		collide_impl_(rhs,lhs);
-}
-
-template<typename CONFIG> bool collide( const any_shape<CONFIG>& lhs, const any_shape<CONFIG>& rhs)
-{
-	if( lhs.empty() || rhs.empty() ) return true;
-	else return collide(lhs.get(), rhs.get());
+	return any_shape<CONFIG>(lhs).collide(any_shape<CONFIG>(rhs));
 }
 
 template<typename CONFIG> bool collide( const any_shape<CONFIG>& lhs, const shape<CONFIG>& rhs)
 {
 	if( lhs.empty() ) return true;
-	else return collide(lhs.get(), rhs);
+	else return lhs.collide(any_shape<CONFIG>(rhs));
 }
 
 template<typename CONFIG> bool collide( const shape<CONFIG>& lhs, const any_shape<CONFIG>& rhs)
 {
 	if( rhs.empty() ) return true;
-	else return collide(lhs, rhs.get());
+	else return any_shape<CONFIG>(lhs).collide(rhs);
 }
 
 template<typename CONFIG> bool collide( const point<CONFIG>& lhs, const point<CONFIG>& rhs)
@@ -380,14 +493,50 @@ template<typename CONFIG> bool collide( const box<CONFIG>& lhs, const box<CONFIG
 
 template<typename CONFIG> box<CONFIG> any_shape<CONFIG>::bbox() const
 {
-	if( content ) return content->bbox();
-	else {
-		box<CONFIG> bx;
-		for( uint i = 0; i<CONFIG::D; ++i ) {
-			bx.get_min()[i] = -std::numeric_limits<typename CONFIG::REAL>::infinity();
-			bx.get_max()[i] = std::numeric_limits<typename CONFIG::REAL>::infinity();
+	box<CONFIG> bx;
+	const REAL inf = std::numeric_limits<REAL>::infinity();
+	for( uint i = 0; i<CONFIG::D; ++i ) {
+		bx.get_min()[i] = universe_ ? -inf : inf;
+		bx.get_max()[i] = universe_ ? inf : -inf;
+		for( std::size_t j = 0; j < boxes_(); ++j ) {
+			bx.get_min()[i] = std::min(bx.get_min()[i], min_[i][j]);
+			bx.get_max()[i] = std::max(bx.get_max()[i], max_[i][j]);
 		}
-		return bx;
+		for( const ball_& b: balls_ ) {
+			bx.get_min()[i] = std::min(bx.get_min()[i], b.center[i] - b.radius);
+			bx.get_max()[i] = std::max(bx.get_max()[i], b.center[i] + b.radius);
+		}
+	}
+	return bx;
+}
+
+template<typename CONFIG> void any_shape<CONFIG>::add_( const shape<CONFIG>& rhs )
+{
+	switch( rhs.type() ) {
+	case shape_type::point: {
+		auto& obj = static_cast<const point<CONFIG>&>(rhs);
+		add_ball_(shape_type::point, obj.get_center(), REAL(0));
+		break;
+	}
+	case shape_type::sphere: {
+		auto& obj = static_cast<const sphere<CONFIG>&>(rhs);
+		add_ball_(shape_type::sphere, obj.get_center(), obj.get_radius());
+		break;
+	}
+	case shape_type::box: {
+		auto& obj = static_cast<const box<CONFIG>&>(rhs);
+		add_box_(obj.get_min(), obj.get_max());
+		break;
+	}
+	case shape_type::or_set: {
+		auto& obj = static_cast<const or_set<CONFIG>&>(rhs);
+		add_(obj.left());
+		add_(obj.right());
+		break;
+	}
+	case shape_type::universe:
+		any_shape().swap(*this);
+		break;
 	}
 }
 
@@ -417,7 +566,7 @@ template<typename CONFIG> box<CONFIG> or_set<CONFIG>::bbox() const
 	box<CONFIG> bx, lhs = lhs_.bbox(), rhs = rhs_.bbox();
 	for( uint i=0; i<CONFIG::D; ++i ){
 		bx.get_min()[i] = std::min(lhs.get_min()[i], rhs.get_min()[i]);
-		bx.get_max()[i] = std::min(lhs.get_max()[i], rhs.get_max()[i]);
+		bx.get_max()[i] = std::max(lhs.get_max()[i], rhs.get_max()[i]);
 	}
 	return bx;
 }
@@ -387,6 +387,76 @@ SCALAR norm( vexpr<E,SCALAR,D> const &u ) {
 	return std::sqrt( normsq(u) );
 }
 
+/*---------------------------------------------------------------------------
+                     Fixed-dimension point kernels
+---------------------------------------------------------------------------*/
+
+// straight-line kernels on the packed storage of point, with no expression
+// temporaries and no checked operator[], so that sampler loops over
+// neighbours reduce to a handful of loads and multiply-adds per point.
+// D = 1, 2, 3 are written out; the sums are taken in the same order as sum()
+template<typename SCALAR, uint D> struct point_kernel {
+	static inline SCALAR normsq_diff( SCALAR const *u, SCALAR const *v ) {
+		SCALAR s = ( u[0] - v[0] ) * ( u[0] - v[0] );
+		for(uint i = 1 ; i < D ; i++) s += ( u[i] - v[i] ) * ( u[i] - v[i] );
+		return s;
+	}
+	static inline SCALAR dot( SCALAR const *u, SCALAR const *v ) {
+		SCALAR s = u[0] * v[0];
+		for(uint i = 1 ; i < D ; i++) s += u[i] * v[i];
+		return s;
+	}
+};
+
+template<typename SCALAR> struct point_kernel<SCALAR,1U> {
+	static inline SCALAR normsq_diff( SCALAR const *u, SCALAR const *v ) {
+		SCALAR const d0 = u[0] - v[0];
+		return d0 * d0;
+	}
+	static inline SCALAR dot( SCALAR const *u, SCALAR const *v ) {
+		return u[0] * v[0];
+	}
+};
+
+template<typename SCALAR> struct point_kernel<SCALAR,2U> {
+	static inline SCALAR normsq_diff( SCALAR const *u, SCALAR const *v ) {
+		SCALAR const d0 = u[0] - v[0], d1 = u[1] - v[1];
+		return d0 * d0 + d1 * d1;
+	}
+	static inline SCALAR dot( SCALAR const *u, SCALAR const *v ) {
+		return u[0] * v[0] + u[1] * v[1];
+	}
+};
+
+template<typename SCALAR> struct point_kernel<SCALAR,3U> {
+	static inline SCALAR normsq_diff( SCALAR const *u, SCALAR const *v ) {
+		SCALAR const d0 = u[0] - v[0], d1 = u[1] - v[1], d2 = u[2] - v[2];
+		return d0 * d0 + d1 * d1 + d2 * d2;
+	}
+	static inline SCALAR dot( SCALAR const *u, SCALAR const *v ) {
+		return u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+	}
+};
+
+// square of the L2 distance between two points, i.e. normsq( u - v )
+template<typename SCALAR, uint D> inline
+SCALAR normsq_diff( point<SCALAR,D> const &u, point<SCALAR,D> const &v ) {
+	static_assert( sizeof(point<SCALAR,D>) == D * sizeof(SCALAR), "MUI Error [point.h]: Point storage is not packed" );
+	return point_kernel<SCALAR,D>::normsq_diff( u.data(), v.data() );
+}
+
+// inner product of two points, preferred over the expression form
+template<typename SCALAR, uint D> inline
+SCALAR dot( point<SCALAR,D> const &u, point<SCALAR,D> const &v ) {
+	return point_kernel<SCALAR,D>::dot( u.data(), v.data() );
+}
+
+// square of L2 norm of a point
+template<typename SCALAR, uint D> inline
+SCALAR normsq( point<SCALAR,D> const &u ) {
+	return point_kernel<SCALAR,D>::dot( u.data(), u.data() );
+}
+
 // element-wise arbitrary function applied for each element
 template<class E, class OP, typename SCALAR, uint D> inline
 vexpr_apply1<E, OP, SCALAR, D> apply( vexpr<E,SCALAR,D> const &u, OP const& op ) {
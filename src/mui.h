@@ -65,6 +65,10 @@
 #include "samplers/temporal/temporal_sampler_gauss.h"
 #include "samplers/temporal/temporal_sampler_mean.h"
 #include "samplers/temporal/temporal_sampler_sum.h"
+#include "samplers/temporal/temporal_sampler_linear.h"
+#include "samplers/temporal/temporal_sampler_hermite.h"
+#include "samplers/temporal/temporal_sampler_lagrange.h"
+#include "samplers/temporal/temporal_sampler_predictor.h"
 
 //Include coupling algorithms
 #include "samplers/algorithm/algo_fixed_relaxation.h"
@@ -75,6 +79,14 @@
 #include "communication/comm.h"
 #include "communication/comm_mpi.h"
 #include "communication/comm_mpi_smart.h"
+#include "communication/comm_inproc.h"
+#ifdef __linux__
+#include "communication/comm_shm.h"
+#include "communication/comm_tcp.h"
+#ifdef MUI_IO_URING
+#include "communication/comm_uring.h"
+#endif
+#endif
 #include "general/dim.h"
 #include "communication/lib_mpi_split.h"
 #include "communication/lib_mpi_multidomain.h"
@@ -89,7 +101,7 @@ namespace mui {
 #define DECLARE_SAMPLER_0ARG(SAMPLER,SUFFIX,CONFIG)	\
 	using SAMPLER ## SUFFIX = SAMPLER<CONFIG>;
 
-#define SPECIALIZE(SUFFIX,REALTYPE,INTTYPE,DIM) \
+#define SPECIALIZE(SUFFIX,REALTYPE,ACCUMTYPE,INTTYPE,DIM) \
 		typedef struct config_##SUFFIX {\
   	  	  	using EXCEPTION = exception_segv;\
   	  	  	static const bool DEBUG = false;\
@@ -97,9 +109,10 @@ namespace mui {
 			static const bool FIXEDPOINTS = false;\
 			static const bool QUIET = false;\
 			using REAL = REALTYPE;\
+			using ACCUM = ACCUMTYPE;\
 			using INT = INTTYPE;\
 			using point_type = point<REAL,D>;\
-			using time_type = REAL;\
+			using time_type = ACCUM;\
 			using iterator_type = INT;\
 			using data_types = type_list<uint32_t,uint64_t,int32_t,int64_t,double,float,point<REAL,3>,std::string>;\
 		} mui_config_##SUFFIX;\
@@ -119,6 +132,11 @@ namespace mui {
 		DECLARE_SAMPLER_0ARG(temporal_sampler_gauss,SUFFIX,config_##SUFFIX);\
 		DECLARE_SAMPLER_0ARG(temporal_sampler_sum,SUFFIX,config_##SUFFIX);\
 		DECLARE_SAMPLER_0ARG(temporal_sampler_mean,SUFFIX,config_##SUFFIX);\
+		DECLARE_SAMPLER_0ARG(temporal_sampler_linear,SUFFIX,config_##SUFFIX);\
+		DECLARE_SAMPLER_0ARG(temporal_sampler_hermite,SUFFIX,config_##SUFFIX);\
+		DECLARE_SAMPLER_0ARG(temporal_sampler_lagrange,SUFFIX,config_##SUFFIX);\
+		DECLARE_SAMPLER_0ARG(temporal_sampler_predictor,SUFFIX,config_##SUFFIX);\
+		DECLARE_SAMPLER_0ARG(temporal_sampler_corrector,SUFFIX,config_##SUFFIX);\
 		DECLARE_SAMPLER_0ARG(algo_fixed_relaxation,SUFFIX,config_##SUFFIX);\
 		DECLARE_SAMPLER_0ARG(algo_aitken,SUFFIX,config_##SUFFIX);\
 		namespace geometry {\
@@ -128,18 +146,26 @@ namespace mui {
 			using or_set##SUFFIX = or_set<config_##SUFFIX>;\
 		}
 
-SPECIALIZE(1d,double,int32_t,1);
-SPECIALIZE(2d,double,int32_t,2);
-SPECIALIZE(3d,double,int32_t,3);
-SPECIALIZE(1dx,double,int64_t,1);
-SPECIALIZE(2dx,double,int64_t,2);
-SPECIALIZE(3dx,double,int64_t,3);
-SPECIALIZE(1f,float,int32_t,1);
-SPECIALIZE(2f,float,int32_t,2);
-SPECIALIZE(3f,float,int32_t,3);
-SPECIALIZE(1fx,float,int64_t,1);
-SPECIALIZE(2fx,float,int64_t,2);
-SPECIALIZE(3fx,float,int64_t,3);
+SPECIALIZE(1d,double,double,int32_t,1);
+SPECIALIZE(2d,double,double,int32_t,2);
+SPECIALIZE(3d,double,double,int32_t,3);
+SPECIALIZE(1dx,double,double,int64_t,1);
+SPECIALIZE(2dx,double,double,int64_t,2);
+SPECIALIZE(3dx,double,double,int64_t,3);
+SPECIALIZE(1f,float,float,int32_t,1);
+SPECIALIZE(2f,float,float,int32_t,2);
+SPECIALIZE(3f,float,float,int32_t,3);
+SPECIALIZE(1fx,float,float,int64_t,1);
+SPECIALIZE(2fx,float,float,int64_t,2);
+SPECIALIZE(3fx,float,float,int64_t,3);
+// mixed precision: float points in storage and on the wire, double time and
+// sampler arithmetic
+SPECIALIZE(1m,float,double,int32_t,1);
+SPECIALIZE(2m,float,double,int32_t,2);
+SPECIALIZE(3m,float,double,int32_t,3);
+SPECIALIZE(1mx,float,double,int64_t,1);
+SPECIALIZE(2mx,float,double,int64_t,2);
+SPECIALIZE(3mx,float,double,int64_t,3);
 
 #undef SPECIALIZE
 
@@ -160,6 +186,11 @@ SPECIALIZE(3fx,float,int64_t,3);
 		DECLARE_SAMPLER_0ARG(temporal_sampler_gauss,SUFFIX,CONFIG);\
 		DECLARE_SAMPLER_0ARG(temporal_sampler_sum,SUFFIX,CONFIG);\
 		DECLARE_SAMPLER_0ARG(temporal_sampler_mean,SUFFIX,CONFIG);\
+		DECLARE_SAMPLER_0ARG(temporal_sampler_linear,SUFFIX,CONFIG);\
+		DECLARE_SAMPLER_0ARG(temporal_sampler_hermite,SUFFIX,CONFIG);\
+		DECLARE_SAMPLER_0ARG(temporal_sampler_lagrange,SUFFIX,CONFIG);\
+		DECLARE_SAMPLER_0ARG(temporal_sampler_predictor,SUFFIX,CONFIG);\
+		DECLARE_SAMPLER_0ARG(temporal_sampler_corrector,SUFFIX,CONFIG);\
 		DECLARE_SAMPLER_0ARG(algo_fixed_relaxation,SUFFIX,CONFIG);\
 		DECLARE_SAMPLER_0ARG(algo_aitken,SUFFIX,CONFIG);\
 		}
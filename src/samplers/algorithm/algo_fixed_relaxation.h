@@ -192,7 +192,7 @@ public:
                         REAL r2min_2nd = std::numeric_limits<REAL>::max();
                         OTYPE value_1st = 0, value_2nd = 0;
                         for( size_t i = 0 ; i < present_iter->second.size() ; i++ ) {
-                            REAL dr2 = normsq( focus - present_iter->second[i].first );
+                            REAL dr2 = normsq_diff( focus, present_iter->second[i].first );
                             if ( dr2 < r2min_1st ) {
                                 r2min_2nd = r2min_1st;
                                 value_2nd = value_1st;
@@ -250,7 +250,7 @@ public:
                         REAL r2min_2nd = std::numeric_limits<REAL>::max();
                         OTYPE value_1st = 0, value_2nd = 0;
                         for( size_t i = 0 ; i < previous_iter->second.size() ; i++ ) {
-                            REAL dr2 = normsq( focus - previous_iter->second[i].first );
+                            REAL dr2 = normsq_diff( focus, previous_iter->second[i].first );
                             if ( dr2 < r2min_1st ) {
                                 r2min_2nd = r2min_1st;
                                 value_2nd = value_1st;
@@ -409,7 +409,7 @@ public:
                         REAL r2min_2nd = std::numeric_limits<REAL>::max();
                         OTYPE value_1st = 0, value_2nd = 0;
                         for( size_t i = 0 ; i < previous_iter->second.size() ; i++ ) {
-                            REAL dr2 = normsq( focus - previous_iter->second[i].first );
+                            REAL dr2 = normsq_diff( focus, previous_iter->second[i].first );
                             if ( dr2 < r2min_1st ) {
                                 r2min_2nd = r2min_1st;
                                 value_2nd = value_1st;
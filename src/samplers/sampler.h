@@ -52,8 +52,28 @@
 #include "../config.h"
 #include "../geometry/geometry.h"
 #include "../storage/virtual_container.h"
+#include <type_traits>
 
 namespace mui {
+
+// arithmetic type samplers accumulate in: CONFIG::ACCUM where the config
+// declares one, CONFIG::REAL otherwise
+template<typename CONFIG, typename = void> struct accum_type {
+	using type = typename CONFIG::REAL;
+};
+template<typename CONFIG> struct accum_type<CONFIG, typename std::conditional<true, void, typename CONFIG::ACCUM>::type> {
+	using type = typename CONFIG::ACCUM;
+};
+
+// how a sampler of OTYPE values accumulates with ATYPE arithmetic: weights are
+// ATYPE and floating-point values are summed in ATYPE where it is wider, so a
+// float field is stored and sent in float but summed in double. Values of any
+// other type (integers, points) are summed as OTYPE with REAL weights.
+template<typename CONFIG, typename OTYPE, typename ATYPE> struct sampler_accum {
+	using value_type  = typename std::conditional<std::is_floating_point<OTYPE>::value && ( sizeof(ATYPE) > sizeof(OTYPE) ),
+	                                              ATYPE, OTYPE>::type;
+	using weight_type = typename std::conditional<std::is_arithmetic<OTYPE>::value, ATYPE, typename CONFIG::REAL>::type;
+};
 /*
 class sampler {
 public:
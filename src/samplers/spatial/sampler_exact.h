@@ -76,7 +76,7 @@ public:
 	template<template<typename,typename> class CONTAINER>
 	inline OTYPE filter( point_type focus, const CONTAINER<ITYPE,CONFIG> &data_points ) const {
 	  for( size_t i = 0 ; i < data_points.size() ; i++ ) {
-			if ( norm( focus - data_points[i].first ) < point_tolerance ) {
+			if ( std::sqrt( normsq_diff( focus, data_points[i].first ) ) < point_tolerance ) {
 				return data_points[i].second;
 			}
 		}
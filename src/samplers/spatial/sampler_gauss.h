@@ -54,33 +54,37 @@
 
 namespace mui {
 
-template<typename CONFIG=default_config, typename O_TP=typename CONFIG::REAL, typename I_TP=O_TP>
+template<typename CONFIG=default_config, typename O_TP=typename CONFIG::REAL, typename I_TP=O_TP,
+         typename A_TP=typename accum_type<CONFIG>::type>
 class sampler_gauss {
 public:
 	using OTYPE      = O_TP;
 	using ITYPE      = I_TP;
+	using ATYPE      = A_TP;
 	using REAL       = typename CONFIG::REAL;
 	using INT        = typename CONFIG::INT;
 	using point_type = typename CONFIG::point_type;
+	using VTYPE      = typename sampler_accum<CONFIG,OTYPE,ATYPE>::value_type;
+	using WTYPE      = typename sampler_accum<CONFIG,OTYPE,ATYPE>::weight_type;
 
-	sampler_gauss( REAL r_, REAL h_ ) : r(r_), h(h_), nh(std::pow(2*PI*h,-0.5*CONFIG::D)) {}
+	sampler_gauss( REAL r_, REAL h_ ) : r(r_), h(h_), nh(std::pow(2*PI*ATYPE(h),-0.5*CONFIG::D)) {}
 
 	template<template<typename,typename> class CONTAINER>
 	inline OTYPE filter( point_type focus, const CONTAINER<ITYPE,CONFIG> &data_points ) const {
-		REAL exp_val = -0.5/h;
+		ATYPE exp_val = -0.5/ATYPE(h);
 		REAL r2 = r*r;
-	  REAL  wsum = 0;
-		OTYPE vsum = 0;
+	  ATYPE wsum = 0;
+		VTYPE vsum = 0;
 		for( size_t i = 0 ; i < data_points.size() ; i++ ) {
-			REAL d = normsq( focus - data_points[i].first );
+			REAL d = normsq_diff( focus, data_points[i].first );
 			if ( d < r2 ) {
-			  REAL w = nh * std::exp( exp_val * d );
-				vsum += data_points[i].second * w;
+			  ATYPE w = nh * std::exp( exp_val * d );
+				vsum += VTYPE( data_points[i].second ) * WTYPE( w );
 				wsum += w;
 			}
 		}
-		if ( wsum ) return vsum / wsum;
-		else return REAL(0.);
+		if ( wsum ) return static_cast<OTYPE>( vsum / WTYPE( wsum ) );
+		else return OTYPE(0.);
 	}
 
 	inline geometry::any_shape<CONFIG> support( point_type focus, REAL domain_mag ) const {
@@ -90,7 +94,7 @@ public:
 protected:
 	REAL r;
 	REAL h;
-	REAL nh;
+	ATYPE nh;
 };
 
 }
@@ -54,14 +54,17 @@
 
 namespace mui {
 
-template<typename CONFIG=default_config, typename O_TP=typename CONFIG::REAL, typename I_TP=O_TP>
+template<typename CONFIG=default_config, typename O_TP=typename CONFIG::REAL, typename I_TP=O_TP,
+         typename A_TP=typename accum_type<CONFIG>::type>
 class sampler_moving_average {
 public:
 	using OTYPE      = O_TP;
 	using ITYPE      = I_TP;
+	using ATYPE      = A_TP;
 	using REAL       = typename CONFIG::REAL;
 	using INT        = typename CONFIG::INT;
 	using point_type = typename CONFIG::point_type;
+	using VTYPE      = typename sampler_accum<CONFIG,OTYPE,ATYPE>::value_type;
 
 	sampler_moving_average( point_type bbox_ ) {
 		bbox  = bbox_;
@@ -70,7 +73,7 @@ public:
 	template<template<typename,typename> class CONTAINER>
 	inline OTYPE filter( point_type focus, const CONTAINER<ITYPE,CONFIG> &data_points ) const {
 	    size_t n(0);
-		OTYPE vsum(0);
+		VTYPE vsum(0);
 		for( size_t i = 0 ; i < data_points.size() ; i++ ) {
             point_type dx(REAL(0.0));
             for (INT j = 0 ; j < CONFIG::D ; j++) {
@@ -79,12 +82,12 @@ public:
 			bool within = true;
 			for( INT i = 0 ; within && i < CONFIG::D ; i++ ) within = within && ( dx[i] < bbox[i] );
 			if ( within ) {
-				vsum += data_points[i].second;
+				vsum += VTYPE( data_points[i].second );
 				n++;
 			}
 		}
 		if (CONFIG::DEBUG) assert( n!=0 );
-		return n ? ( vsum / OTYPE(n) ): OTYPE(0.);
+		return n ? static_cast<OTYPE>( vsum / VTYPE(n) ): OTYPE(0.);
 	}
 
 	inline geometry::any_shape<CONFIG> support( point_type focus, REAL domain_mag ) const {
@@ -70,7 +70,7 @@ public:
 		REAL r2min_2nd = std::numeric_limits<REAL>::max();
 		OTYPE value_1st = 0, value_2nd = 0;
 		for( size_t i = 0 ; i < data_points.size() ; i++ ) {
-			REAL dr2 = normsq( focus - data_points[i].first );
+			REAL dr2 = normsq_diff( focus, data_points[i].first );
 			if ( dr2 < r2min_1st ) {
 				r2min_2nd = r2min_1st;
 				value_2nd = value_1st;
@@ -69,7 +69,7 @@ public:
 		REAL r2min = std::numeric_limits<REAL>::max();
 		OTYPE value = 0;
 		for( size_t i = 0 ; i < data_points.size() ; i++ ) {
-			REAL dr2 = normsq( focus - data_points[i].first );
+			REAL dr2 = normsq_diff( focus, data_points[i].first );
 			if ( dr2 < r2min ) {
 				r2min = dr2;
 				value = data_points[i].second ;
@@ -271,7 +271,7 @@ public:
           ///   below code will ensure a correct match between the remote point and corresponding coupling matrix element.
           OTYPE HElement = 0;
 
-          if (normsq(remote_pts_[j] - data_points[j].first) < (std::numeric_limits<REAL>::epsilon() + tolerance)){
+          if (normsq_diff(remote_pts_[j], data_points[j].first) < (std::numeric_limits<REAL>::epsilon() + tolerance)){
               HElement = H_.get_value(i, j);
           }
           else {
@@ -1065,9 +1065,7 @@ private:
                         int glob_i = connectivityAB_[row][i];
                         int glob_j = connectivityAB_[row][j];
 
-                        auto d = norm(
-                                data_points[glob_i].first
-                                        - data_points[glob_j].first);
+                        auto d = std::sqrt(normsq_diff(data_points[glob_i].first, data_points[glob_j].first));
 
                         if (d < r_) {
                             REAL w = rbf(d);
@@ -1109,7 +1107,7 @@ private:
                 for (size_t j = 0; j < NP; j++) {
                     int glob_j = connectivityAB_[row][j];
 
-                    auto d = norm(ptsExtend_[row] - data_points[glob_j].first);
+                    auto d = std::sqrt(normsq_diff(ptsExtend_[row], data_points[glob_j].first));
 
                     if (d < r_) {
                         Aas_coo.set_value(j, 0, rbf(d), false);
@@ -1218,7 +1216,7 @@ private:
 
             for ( size_t i = 0; i < data_points.size(); i++ ) {
                 for ( size_t j = i; j < data_points.size(); j++ ) {
-                    auto d = norm(data_points[i].first - data_points[j].first);
+                    auto d = std::sqrt(normsq_diff(data_points[i].first, data_points[j].first));
 
                     if ( d < r_ ) {
                         REAL w = rbf(d);
@@ -1239,7 +1237,7 @@ private:
 
             for ( size_t i = 0; i < ptsExtend_.size(); i++ ) {
                 for ( size_t j = 0; j < data_points.size(); j++ ) {
-                    auto d = norm(ptsExtend_[i] - data_points[j].first);
+                    auto d = std::sqrt(normsq_diff(ptsExtend_[i], data_points[j].first));
 
                     if ( d < r_ ) {
 
@@ -1352,7 +1350,7 @@ private:
                         INT glob_i = connectivityAB_[row][i];
                         INT glob_j = connectivityAB_[row][j];
 
-                        auto d = norm(ptsExtend_[glob_i] - ptsExtend_[glob_j]);
+                        auto d = std::sqrt(normsq_diff(ptsExtend_[glob_i], ptsExtend_[glob_j]));
 
                         if (d < r_) {
                             REAL w = rbf(d);
@@ -1391,7 +1389,7 @@ private:
                 for (size_t j = 0; j < NP; j++) {
                     INT glob_j = connectivityAB_[row][j];
 
-                    auto d = norm(data_points[row].first - ptsExtend_[glob_j]);
+                    auto d = std::sqrt(normsq_diff(data_points[row].first, ptsExtend_[glob_j]));
 
                     if (d < r_) {
                         Aas_coo.set_value(j, 0, rbf(d), false);
@@ -1503,7 +1501,7 @@ private:
 
             for ( size_t i = 0; i < ptsExtend_.size(); i++ ) {
                 for ( size_t j = i; j < ptsExtend_.size(); j++ ) {
-                    auto d = norm(ptsExtend_[i] - ptsExtend_[j]);
+                    auto d = std::sqrt(normsq_diff(ptsExtend_[i], ptsExtend_[j]));
 
                     if ( d < r_ ) {
                         REAL w = rbf(d);
@@ -1525,7 +1523,7 @@ private:
 
             for ( size_t i = 0; i < data_points.size(); i++ ) {
                 for ( size_t j = 0; j < ptsExtend_.size(); j++ ) {
-                    auto d = norm(data_points[i].first - ptsExtend_[j]);
+                    auto d = std::sqrt(normsq_diff(data_points[i].first, ptsExtend_[j]));
 
                     if ( d < r_ ) {
                         Aas_coo.set_value(i, (j + CONFIG::D + 1), rbf(d), false);
@@ -1691,7 +1689,7 @@ private:
                     if (added != connectivityAB_[i].end())
                         continue;
 
-                    auto d = normsq(ptsExtend_[i] - data_points[j].first);
+                    auto d = normsq_diff(ptsExtend_[i], data_points[j].first);
                     if (d < cur) {
                         cur = d;
                         bestj = j;
@@ -1817,7 +1815,7 @@ private:
                     if (added != connectivityAB_[i].end())
                         continue;
 
-                    auto d = normsq(data_points[i].first - ptsExtend_[j]);
+                    auto d = normsq_diff(data_points[i].first, ptsExtend_[j]);
                     if (d < cur) {
                         cur = d;
                         bestj = j;
@@ -1912,7 +1910,7 @@ private:
                     if (added != connectivityAA_[i].end())
                         continue;
 
-                    auto d = normsq(ptsExtend_[i] - ptsExtend_[j]);
+                    auto d = normsq_diff(ptsExtend_[i], ptsExtend_[j]);
                     if (d < cur) {
                         cur = d;
                         bestj = j;
@@ -1937,7 +1935,7 @@ private:
 
     //Radial basis function for two points
     inline REAL rbf(point_type x1, point_type x2) const {
-        auto d = norm(x1 - x2);
+        auto d = std::sqrt(normsq_diff(x1, x2));
         return rbf(d);
     }
 
@@ -55,21 +55,25 @@
 namespace mui
 {
 
-template<typename CONFIG=default_config, typename O_TP=typename CONFIG::REAL, typename I_TP=O_TP>
+template<typename CONFIG=default_config, typename O_TP=typename CONFIG::REAL, typename I_TP=O_TP,
+         typename A_TP=typename accum_type<CONFIG>::type>
 class sampler_shepard_quintic
 {
 public:
     using OTYPE      = O_TP;
     using ITYPE      = I_TP;
+    using ATYPE      = A_TP;
     using REAL       = typename CONFIG::REAL;
     using INT        = typename CONFIG::INT;
     using point_type = typename CONFIG::point_type;
+    using VTYPE      = typename sampler_accum<CONFIG,OTYPE,ATYPE>::value_type;
+    using WTYPE      = typename sampler_accum<CONFIG,OTYPE,ATYPE>::weight_type;
     const static int D = CONFIG::D;
 
-    sampler_shepard_quintic( REAL r_ ) : r( r_ ), hinv( REAL( 3 ) / r_ )
+    sampler_shepard_quintic( REAL r_ ) : r( r_ ), hinv( ATYPE( 3 ) / r_ )
     {
         static_assert( D == 1 || D == 2 || D == 3, "Quintic kernel for dimension other than 1,2,3 not defined." );
-        REAL sigma;
+        ATYPE sigma;
         switch( D ) {
         case 1:
             sigma = 1.0 / 120.0;
@@ -87,18 +91,18 @@ public:
     template<template<typename, typename> class CONTAINER>
     inline OTYPE filter( point_type focus, const CONTAINER<ITYPE, CONFIG> &data_points ) const
     {
-        OTYPE vsum = 0;
-        REAL  wsum = 0;
+        VTYPE vsum = 0;
+        ATYPE wsum = 0;
         for( size_t i = 0 ; i < data_points.size() ; i++ ) {
-            auto dist2 = normsq( focus - data_points[i].first );
+            auto dist2 = normsq_diff( focus, data_points[i].first );
             if( dist2 < r * r ) {
-                REAL w = quintic_polynomial( sqrt( dist2 ) );
-                vsum += data_points[i].second * w;
+                ATYPE w = quintic_polynomial( std::sqrt( ATYPE( dist2 ) ) );
+                vsum += VTYPE( data_points[i].second ) * WTYPE( w );
                 wsum += w;
             }
         }
-        if( wsum ) return vsum / wsum;
-        else return 0;
+        if( wsum ) return static_cast<OTYPE>( vsum / WTYPE( wsum ) );
+        else return OTYPE( 0 );
     }
 
     inline geometry::any_shape<CONFIG> support( point_type focus, REAL domain_mag ) const
@@ -107,13 +111,14 @@ public:
     }
 
 protected:
-    REAL r, hinv, norm_factor;
+    REAL r;
+    ATYPE hinv, norm_factor;
 
-    inline REAL quintic_polynomial( const REAL dist ) const
+    inline ATYPE quintic_polynomial( const ATYPE dist ) const
     {
-        REAL s, w;
-        REAL s1, s2, s3;
-        REAL s1_5, s2_5, s3_5;
+        ATYPE s, w;
+        ATYPE s1, s2, s3;
+        ATYPE s1_5, s2_5, s3_5;
         s = dist * hinv;
         s1 = 1.0 - s;
         s2 = 2.0 - s;
@@ -97,6 +97,35 @@ public:
 		return TYPE();
 	}
 
+	//- Weights w of the frames at times such that filter() returns sum(w[i]*value[i])/divisor, returns the divisor
+	REAL weights( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		w.assign(times.size(), REAL(0));
+		for( size_t i = 0; i < times.size(); i++ ) {
+			if ( std::abs(times[i].first - focus) <= tolerance_time ) {
+				w[i] = REAL(1);
+				break;
+			}
+		}
+		return REAL(1);
+	}
+
+	REAL weights( std::pair<time_type,iterator_type> focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		w.assign(times.size(), REAL(0));
+		for( size_t i = 0; i < times.size(); i++ ) {
+			time_type dt = std::abs(times[i].first - focus.first);
+			iterator_type di = std::abs(times[i].second - focus.second);
+			if ( dt <= tolerance_time && di <= tolerance_it ) {
+				w[i] = REAL(1);
+				break;
+			}
+		}
+		return REAL(1);
+	}
+
+	bool operator==( const temporal_sampler_exact& rhs ) const {
+		return tolerance_time == rhs.tolerance_time && tolerance_it == rhs.tolerance_it;
+	}
+
 	template<typename TYPE>
 	TYPE get_upper_bound( TYPE focus ) const {
 		return focus;
@@ -97,6 +97,30 @@ public:
 		return ( wsum > std::numeric_limits<REAL>::epsilon() ) ? ( vsum / wsum ) : TYPE(0);
 	}
 
+	//- Weights w of the frames at times such that filter() returns sum(w[i]*value[i])/divisor, returns the divisor
+	REAL weights( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		REAL wsum = REAL(0);
+		w.assign(times.size(), REAL(0));
+		for( size_t i = 0; i < times.size(); i++ ) {
+			time_type dt = std::abs(times[i].first - focus);
+			if ( dt < cutoff_ ) {
+				w[i] = pow( 2*PI*sigma_, -0.5 ) * exp( -0.5 * dt * dt / sigma_ );
+				wsum += w[i];
+			}
+		}
+		if ( wsum > std::numeric_limits<REAL>::epsilon() ) return wsum;
+		w.assign(times.size(), REAL(0));
+		return REAL(1);
+	}
+
+	REAL weights( std::pair<time_type,iterator_type> focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		return weights( focus.first, times, w );
+	}
+
+	bool operator==( const temporal_sampler_gauss& rhs ) const {
+		return cutoff_ == rhs.cutoff_ && sigma_ == rhs.sigma_;
+	}
+
 	time_type get_upper_bound( time_type focus ) const {
 		return focus + cutoff_;
 	}
@@ -0,0 +1,155 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+******************************************************************************/
+
+
+/**
+ * @file temporal_sampler_hermite.h
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Temporal sampler that applies cubic Hermite interpolation between
+ * the frames either side of the time requested. The slope at each frame is
+ * the derivative of the parabola through it and the two frames before, so
+ * only frames up to the first one after the time requested are needed and
+ * the interpolant is continuously differentiable from one interval to the next.
+ */
+
+#ifndef MUI_TEMPORAL_SAMPLER_HERMITE_H_
+#define MUI_TEMPORAL_SAMPLER_HERMITE_H_
+
+#include "../../general/util.h"
+#include "../../config.h"
+#include "temporal_sampler_weighted.h"
+
+namespace mui {
+
+template<typename CONFIG=default_config> class temporal_sampler_hermite : public temporal_sampler_weighted<temporal_sampler_hermite<CONFIG>,CONFIG> {
+public:
+	using REAL       	= typename CONFIG::REAL;
+	using INT        	= typename CONFIG::INT;
+	using time_type  	= typename CONFIG::time_type;
+	using iterator_type = typename CONFIG::iterator_type;
+
+	//- span: three times the longest time between two frames of the sender, frames are looked for in [ now - span, now + span ]
+	temporal_sampler_hermite( time_type span ) {
+		span_ = span;
+	}
+
+	//- Weights w of the frames at times such that filter() returns sum(w[i]*value[i])/divisor, returns the divisor
+	REAL weights( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		w.assign(times.size(), REAL(0));
+
+		// one frame per time (the last iteration) up to the first frame after the focus, times are in order
+		std::vector<size_t> f;
+		for( size_t i = 0; i < times.size(); i++ ) {
+			if ( times[i].first <= focus ) {
+				if ( !f.empty() && times[f.back()].first == times[i].first ) f.back() = i;
+				else f.push_back(i);
+			}
+			else { f.push_back(i); break; }
+		}
+
+		if ( f.empty() ) return REAL(1);
+
+		const size_t n = f.size();
+		if ( n == 1 || times[f[n-1]].first <= focus ) { w[f[n-1]] = REAL(1); return REAL(1); }
+		if ( almost_equal(times[f[n-2]].first, focus) ) { w[f[n-2]] = REAL(1); return REAL(1); }
+
+		const time_type h = times[f[n-1]].first - times[f[n-2]].first;
+		const REAL s = static_cast<REAL>( (focus - times[f[n-2]].first) / h );
+
+		// value = h00 v1 + h01 v2 + h (h10 m1 + h11 m2) between frames 1 = f[n-2] and 2 = f[n-1]
+		w[f[n-2]] += (REAL(1) + REAL(2)*s) * (REAL(1)-s) * (REAL(1)-s);
+		w[f[n-1]] += s * s * (REAL(3) - REAL(2)*s);
+		slope_( times, f, n-2, static_cast<REAL>(h) * s * (REAL(1)-s) * (REAL(1)-s), w );
+		slope_( times, f, n-1, static_cast<REAL>(h) * s * s * (s - REAL(1)), w );
+
+		return REAL(1);
+	}
+
+	REAL weights( std::pair<time_type,iterator_type> focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		return weights( focus.first, times, w );
+	}
+
+	bool operator==( const temporal_sampler_hermite& rhs ) const {
+		return span_ == rhs.span_;
+	}
+
+	//- Fetch waits for the sender to reach the focus only, the frame after it is then in the log
+	template<typename TYPE>
+	TYPE get_upper_bound( TYPE focus ) const {
+		return focus;
+	}
+
+	time_type get_lower_bound( time_type focus ) const {
+		return focus - span_;
+	}
+
+	time_type get_frame_upper_bound( time_type focus ) const {
+		return focus + span_;
+	}
+
+	time_type tolerance() const {
+		return time_type(0);
+	}
+
+protected:
+	//- Adds c times the weights of the slope at frame f[k]: the derivative of the parabola through
+	// it and the two frames before, or the secant to its neighbour if there are fewer
+	void slope_( const std::vector<std::pair<time_type,iterator_type> > &times, const std::vector<size_t> &f,
+	             size_t k, REAL c, std::vector<REAL> &w ) const {
+		if ( k >= 2 ) {
+			const REAL a = static_cast<REAL>( times[f[k-1]].first - times[f[k-2]].first );
+			const REAL b = static_cast<REAL>( times[f[k]].first - times[f[k-1]].first );
+			w[f[k-2]] += c * b / (a * (a + b));
+			w[f[k-1]] -= c * (a + b) / (a * b);
+			w[f[k]]   += c * (a + REAL(2)*b) / (b * (a + b));
+		}
+		else {
+			const REAL b = static_cast<REAL>( times[f[1]].first - times[f[0]].first );
+			w[f[1]] += c / b;
+			w[f[0]] -= c / b;
+		}
+	}
+
+	time_type span_;
+};
+
+}
+
+#endif /* MUI_TEMPORAL_SAMPLER_HERMITE_H_ */
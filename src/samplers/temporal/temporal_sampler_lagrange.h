@@ -0,0 +1,179 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+******************************************************************************/
+
+
+/**
+ * @file temporal_sampler_lagrange.h
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Temporal sampler that applies Lagrange polynomial interpolation
+ * through the first frame after the time requested and the frames before
+ * it, up to a given order.
+ */
+
+#ifndef MUI_TEMPORAL_SAMPLER_LAGRANGE_H_
+#define MUI_TEMPORAL_SAMPLER_LAGRANGE_H_
+
+#include "../../general/util.h"
+#include "../../config.h"
+#include "temporal_sampler_weighted.h"
+
+namespace mui {
+
+//- Lagrange polynomial weights over frames, shared by the samplers that interpolate or extrapolate with them
+template<typename CONFIG=default_config> class lagrange_polynomial {
+public:
+	using REAL       	= typename CONFIG::REAL;
+	using INT        	= typename CONFIG::INT;
+	using time_type  	= typename CONFIG::time_type;
+	using iterator_type = typename CONFIG::iterator_type;
+
+	lagrange_polynomial( time_type span, INT order ) : span_(span), order_(order) {}
+
+	//- Weights of the polynomial through the first frame after the focus and the order frames before it,
+	//- the frame at the focus if there is one, or the last frame if none is after the focus yet
+	void interpolate( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		w.assign(times.size(), REAL(0));
+
+		std::vector<size_t> f;
+		frames_( focus, times, f );
+
+		if ( f.empty() ) return;
+
+		for( size_t j: f ) {
+			if ( almost_equal(times[j].first, focus) ) { w[j] = REAL(1); return; }
+		}
+
+		// no frame after the focus yet, hold the last one
+		const size_t n = f.size();
+		if ( times[f[n-1]].first <= focus ) { w[f[n-1]] = REAL(1); return; }
+
+		add( focus, times, f, w, REAL(1) );
+	}
+
+	//- Adds c times the weights of the polynomial through the last order+1 frames of f at focus,
+	// L_j(focus) = prod_{k != j} (focus - t_k) / (t_j - t_k)
+	void add( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, const std::vector<size_t> &f,
+	          std::vector<REAL> &w, REAL c ) const {
+		const size_t n = f.size();
+		const size_t first = ( n > static_cast<size_t>(order_) + 1 ) ? n - static_cast<size_t>(order_) - 1 : 0;
+
+		for( size_t j = first; j < n; j++ ) {
+			REAL l = c;
+			for( size_t k = first; k < n; k++ ) {
+				if ( k == j ) continue;
+				l *= static_cast<REAL>( (focus - times[f[k]].first) / (times[f[j]].first - times[f[k]].first) );
+			}
+			w[f[j]] += l;
+		}
+	}
+
+	bool operator==( const lagrange_polynomial& rhs ) const {
+		return span_ == rhs.span_ && order_ == rhs.order_;
+	}
+
+	time_type span() const { return span_; }
+	INT order() const { return order_; }
+
+private:
+	//- One frame per time (the last iteration) up to the first frame after the focus into f, times are in order
+	void frames_( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<size_t> &f ) const {
+		for( size_t i = 0; i < times.size(); i++ ) {
+			if ( times[i].first <= focus ) {
+				if ( !f.empty() && times[f.back()].first == times[i].first ) f.back() = i;
+				else f.push_back(i);
+			}
+			else { f.push_back(i); break; }
+		}
+	}
+
+	time_type span_;
+	INT order_;
+};
+
+template<typename CONFIG=default_config> class temporal_sampler_lagrange : public temporal_sampler_weighted<temporal_sampler_lagrange<CONFIG>,CONFIG> {
+public:
+	using REAL       	= typename CONFIG::REAL;
+	using INT        	= typename CONFIG::INT;
+	using time_type  	= typename CONFIG::time_type;
+	using iterator_type = typename CONFIG::iterator_type;
+
+	//- span: order times the longest time between two frames of the sender, frames are looked for in [ now - span, now + span ]
+	//- order: degree of the polynomial, it uses order+1 frames and is lowered when fewer are in the log
+	temporal_sampler_lagrange( time_type span, INT order = 3 ) : poly_( span, order ) {}
+
+	//- Weights w of the frames at times such that filter() returns sum(w[i]*value[i])/divisor, returns the divisor
+	REAL weights( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		poly_.interpolate( focus, times, w );
+		return REAL(1);
+	}
+
+	REAL weights( std::pair<time_type,iterator_type> focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		return weights( focus.first, times, w );
+	}
+
+	bool operator==( const temporal_sampler_lagrange& rhs ) const {
+		return poly_ == rhs.poly_;
+	}
+
+	//- Fetch waits for the sender to reach the focus only, the frame after it is then in the log
+	template<typename TYPE>
+	TYPE get_upper_bound( TYPE focus ) const {
+		return focus;
+	}
+
+	time_type get_lower_bound( time_type focus ) const {
+		return focus - poly_.span();
+	}
+
+	time_type get_frame_upper_bound( time_type focus ) const {
+		return focus + poly_.span();
+	}
+
+	time_type tolerance() const {
+		return time_type(0);
+	}
+
+private:
+	lagrange_polynomial<CONFIG> poly_;
+};
+
+}
+
+#endif /* MUI_TEMPORAL_SAMPLER_LAGRANGE_H_ */
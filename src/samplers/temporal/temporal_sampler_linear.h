@@ -0,0 +1,126 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+******************************************************************************/
+
+
+/**
+ * @file temporal_sampler_linear.h
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Temporal sampler that interpolates linearly between the frames
+ * either side of the time requested.
+ */
+
+#ifndef MUI_TEMPORAL_SAMPLER_LINEAR_H_
+#define MUI_TEMPORAL_SAMPLER_LINEAR_H_
+
+#include "../../general/util.h"
+#include "../../config.h"
+#include "temporal_sampler_weighted.h"
+
+namespace mui {
+
+template<typename CONFIG=default_config> class temporal_sampler_linear : public temporal_sampler_weighted<temporal_sampler_linear<CONFIG>,CONFIG> {
+public:
+	using REAL       	= typename CONFIG::REAL;
+	using INT        	= typename CONFIG::INT;
+	using time_type  	= typename CONFIG::time_type;
+	using iterator_type = typename CONFIG::iterator_type;
+
+	//- span: the longest time between two frames of the sender, frames are looked for in [ now - span, now + span ]
+	temporal_sampler_linear( time_type span ) {
+		span_ = span;
+	}
+
+	//- Weights w of the frames at times such that filter() returns sum(w[i]*value[i])/divisor, returns the divisor
+	REAL weights( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		w.assign(times.size(), REAL(0));
+
+		// last frame at or before the focus and first frame after it, times are in order
+		size_t lo = times.size(), hi = times.size();
+		for( size_t i = 0; i < times.size(); i++ ) {
+			if ( times[i].first <= focus ) lo = i;
+			else { hi = i; break; }
+		}
+
+		if ( lo == times.size() && hi == times.size() ) return REAL(1);
+
+		if ( lo == times.size() ) w[hi] = REAL(1);
+		else if ( hi == times.size() || almost_equal(times[lo].first, focus) ) w[lo] = REAL(1);
+		else {
+			REAL s = static_cast<REAL>( (focus - times[lo].first) / (times[hi].first - times[lo].first) );
+			w[lo] = REAL(1) - s;
+			w[hi] = s;
+		}
+
+		return REAL(1);
+	}
+
+	REAL weights( std::pair<time_type,iterator_type> focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		return weights( focus.first, times, w );
+	}
+
+	bool operator==( const temporal_sampler_linear& rhs ) const {
+		return span_ == rhs.span_;
+	}
+
+	//- Fetch waits for the sender to reach the focus only, the frame after it is then in the log
+	template<typename TYPE>
+	TYPE get_upper_bound( TYPE focus ) const {
+		return focus;
+	}
+
+	time_type get_lower_bound( time_type focus ) const {
+		return focus - span_;
+	}
+
+	time_type get_frame_upper_bound( time_type focus ) const {
+		return focus + span_;
+	}
+
+	time_type tolerance() const {
+		return time_type(0);
+	}
+
+protected:
+	time_type span_;
+};
+
+}
+
+#endif /* MUI_TEMPORAL_SAMPLER_LINEAR_H_ */
@@ -0,0 +1,276 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+******************************************************************************/
+
+
+/**
+ * @file temporal_sampler_predictor.h
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Temporal samplers that let a fetch run ahead of the sender:
+ * the predictor extrapolates in time from the last frames every peer has
+ * committed when the frame requested has not arrived yet, the corrector
+ * gives the difference to add once it has.
+ */
+
+#ifndef MUI_TEMPORAL_SAMPLER_PREDICTOR_H_
+#define MUI_TEMPORAL_SAMPLER_PREDICTOR_H_
+
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "../../general/util.h"
+#include "../../config.h"
+#include "temporal_sampler_lagrange.h"
+
+namespace mui {
+
+template<typename CONFIG> class temporal_sampler_corrector;
+
+template<typename CONFIG=default_config> class temporal_sampler_predictor : public temporal_sampler_weighted<temporal_sampler_predictor<CONFIG>,CONFIG> {
+public:
+	using REAL       	= typename CONFIG::REAL;
+	using INT        	= typename CONFIG::INT;
+	using time_type  	= typename CONFIG::time_type;
+	using iterator_type = typename CONFIG::iterator_type;
+	using EXCEPTION     = typename CONFIG::EXCEPTION;
+
+	//- Only frames every peer has committed are passed to weights() and filter()
+	static const bool PREDICTS = true;
+
+	//- lag: how far the senders may be behind the time fetched, the barrier waits for now - lag only
+	//- span: how far back frames are looked for, order times the longest time between two frames of the sender
+	//- order: degree of the extrapolating polynomial, it uses order+1 frames
+	//- relaxation: factor of the correction given by corrector()
+	temporal_sampler_predictor( time_type lag, time_type span, INT order = 1, REAL relaxation = REAL(1) )
+		: poly_( span, order ), history_( std::make_shared<history_t>() ) {
+		lag_ = lag;
+		relaxation_ = relaxation;
+	}
+
+	//- Weights w of the frames at times such that filter() returns sum(w[i]*value[i])/divisor, returns the divisor
+	//- Interpolates as temporal_sampler_lagrange once a frame at or after the focus is there, else extrapolates
+	REAL weights( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		if ( arrived_( focus, times ) ) {
+			poly_.interpolate( focus, times, w );
+			return REAL(1);
+		}
+		if ( !extrapolable_( focus, times ) )
+			EXCEPTION(std::runtime_error("MUI Error [temporal_sampler_predictor.h]: Fewer than order+1 frames before the time to predict"));
+
+		w.assign(times.size(), REAL(0));
+		extrapolate_( focus, times, w, REAL(1), times.back().first );
+		record_( focus, times.back().first );
+
+		return REAL(1);
+	}
+
+	REAL weights( std::pair<time_type,iterator_type> focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		return weights( focus.first, times, w );
+	}
+
+	bool operator==( const temporal_sampler_predictor& rhs ) const {
+		return poly_ == rhs.poly_ && lag_ == rhs.lag_ && relaxation_ == rhs.relaxation_ && history_ == rhs.history_;
+	}
+
+	//- True if weights() has a value at the focus: a frame at or after it is there, or order+1
+	//- frames before it to extrapolate from. Fetch waits for the frame at the focus otherwise.
+	bool predictable( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times ) const {
+		return arrived_( focus, times ) || extrapolable_( focus, times );
+	}
+
+	bool predictable( std::pair<time_type,iterator_type> focus, const std::vector<std::pair<time_type,iterator_type> > &times ) const {
+		return predictable( focus.first, times );
+	}
+
+	//- Sampler that fetches the correction of a value predicted at the same time, waiting for its frame.
+	//- It shares the frames each prediction used with this sampler and its copies, and has to be fetched
+	//- before they predict past lag + span after that time.
+	temporal_sampler_corrector<CONFIG> corrector() const {
+		return temporal_sampler_corrector<CONFIG>( *this );
+	}
+
+	template<typename TYPE>
+	TYPE get_upper_bound( TYPE focus ) const {
+		return focus;
+	}
+
+	//- Fetch waits for the senders to reach now - lag only
+	time_type get_upper_bound( time_type focus ) const {
+		return focus - lag_;
+	}
+
+	time_type get_lower_bound( time_type focus ) const {
+		return focus - poly_.span();
+	}
+
+	time_type get_frame_upper_bound( time_type focus ) const {
+		return focus + poly_.span();
+	}
+
+	time_type tolerance() const {
+		return time_type(0);
+	}
+
+private:
+	friend class temporal_sampler_corrector<CONFIG>;
+
+	//- True if a frame at or after the focus is among times
+	bool arrived_( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times ) const {
+		return !times.empty() && ( times.back().first > focus || almost_equal(times.back().first, focus) );
+	}
+
+	//- One frame per time (the last iteration) before the focus and up to last into f, times are in order
+	void before_( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<size_t> &f,
+	              time_type last = std::numeric_limits<time_type>::max() ) const {
+		for( size_t i = 0; i < times.size(); i++ ) {
+			if ( times[i].first >= focus || almost_equal(times[i].first, focus) || times[i].first > last ) break;
+			if ( !f.empty() && times[f.back()].first == times[i].first ) f.back() = i;
+			else f.push_back(i);
+		}
+	}
+
+	//- True if there are order+1 frames before the focus and up to last
+	bool extrapolable_( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times,
+	                    time_type last = std::numeric_limits<time_type>::max() ) const {
+		std::vector<size_t> f;
+		before_( focus, times, f, last );
+		return f.size() > static_cast<size_t>(poly_.order());
+	}
+
+	//- Adds c times the weights of the polynomial through the last order+1 frames before the focus and up to last
+	void extrapolate_( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w, REAL c,
+	                   time_type last ) const {
+		std::vector<size_t> f;
+		before_( focus, times, f, last );
+		poly_.add( focus, times, f, w, c );
+	}
+
+	//- Keeps the time of the last frame the prediction at focus used, forgets those too old to be corrected
+	void record_( time_type focus, time_type last ) const {
+		std::lock_guard<std::mutex> lock( history_->mutex );
+		history_->last[focus] = last;
+		history_->last.erase( history_->last.begin(), history_->last.lower_bound( focus - lag_ - poly_.span() ) );
+	}
+
+	//- Time of the last frame the prediction at focus used into last, false if none extrapolated to it
+	bool recorded_( time_type focus, time_type &last ) const {
+		std::lock_guard<std::mutex> lock( history_->mutex );
+		auto itr = history_->last.find( focus );
+		if ( itr == history_->last.end() ) return false;
+		last = itr->second;
+		return true;
+	}
+
+	//- Last frame time of each prediction, shared by the copies of a predictor and their correctors
+	struct history_t {
+		std::mutex mutex;
+		std::map<time_type,time_type> last;
+	};
+
+	lagrange_polynomial<CONFIG> poly_;
+	std::shared_ptr<history_t> history_;
+	time_type lag_;
+	REAL relaxation_;
+};
+
+template<typename CONFIG=default_config> class temporal_sampler_corrector : public temporal_sampler_weighted<temporal_sampler_corrector<CONFIG>,CONFIG> {
+public:
+	using REAL       	= typename CONFIG::REAL;
+	using INT        	= typename CONFIG::INT;
+	using time_type  	= typename CONFIG::time_type;
+	using iterator_type = typename CONFIG::iterator_type;
+
+	//- The corrector waits for the frame and sees all of it
+	static const bool PREDICTS = false;
+
+	explicit temporal_sampler_corrector( const temporal_sampler_predictor<CONFIG> &predictor )
+		: predictor_( predictor ) {}
+
+	//- Weights of relaxation * (value - prediction) at the focus, the prediction extrapolated from the frames
+	//- the predictor used then. Zero while no frame at or after the focus is there and when the predictor
+	//- did not extrapolate to it, as it had too few frames and waited for the frame instead.
+	REAL weights( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		time_type last;
+		if ( !predictor_.arrived_( focus, times ) || !predictor_.recorded_( focus, last ) ||
+		     !predictor_.extrapolable_( focus, times, last ) ) {
+			w.assign(times.size(), REAL(0));
+			return REAL(1);
+		}
+
+		predictor_.poly_.interpolate( focus, times, w );
+		for( auto& wi: w ) wi *= predictor_.relaxation_;
+		predictor_.extrapolate_( focus, times, w, -predictor_.relaxation_, last );
+
+		return REAL(1);
+	}
+
+	REAL weights( std::pair<time_type,iterator_type> focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		return weights( focus.first, times, w );
+	}
+
+	bool operator==( const temporal_sampler_corrector& rhs ) const {
+		return predictor_ == rhs.predictor_;
+	}
+
+	//- Fetch waits for the senders to reach the focus
+	template<typename TYPE>
+	TYPE get_upper_bound( TYPE focus ) const {
+		return focus;
+	}
+
+	time_type get_lower_bound( time_type focus ) const {
+		return predictor_.get_lower_bound( focus );
+	}
+
+	time_type get_frame_upper_bound( time_type focus ) const {
+		return predictor_.get_frame_upper_bound( focus );
+	}
+
+	time_type tolerance() const {
+		return predictor_.tolerance();
+	}
+
+private:
+	temporal_sampler_predictor<CONFIG> predictor_;
+};
+
+}
+
+#endif /* MUI_TEMPORAL_SAMPLER_PREDICTOR_H_ */
@@ -93,6 +93,26 @@ public:
 		return sum;
 	}
 
+	//- Weights w of the frames at times such that filter() returns sum(w[i]*value[i])/divisor, returns the divisor
+	REAL weights( time_type focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		w.assign(times.size(), REAL(0));
+		for( size_t i = 0; i < times.size(); i++ ) {
+			if ( times[i].first <= focus + right_ && times[i].first >= focus - left_ ) {
+				w[i] = REAL(1);
+			}
+		}
+
+		return REAL(1);
+	}
+
+	REAL weights( std::pair<time_type,iterator_type> focus, const std::vector<std::pair<time_type,iterator_type> > &times, std::vector<REAL> &w ) const {
+		return weights( focus.first, times, w );
+	}
+
+	bool operator==( const temporal_sampler_sum& rhs ) const {
+		return left_ == rhs.left_ && right_ == rhs.right_;
+	}
+
 	time_type get_upper_bound( time_type focus ) const {
 		return focus + right_;
 	}
@@ -0,0 +1,90 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+******************************************************************************/
+
+
+
+/**
+ * @file temporal_sampler_weighted.h
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Base of the temporal samplers given by their weights(): filter()
+ * combines the frames with the weights the derived sampler DERIVED returns.
+ */
+
+#ifndef MUI_TEMPORAL_SAMPLER_WEIGHTED_H_
+#define MUI_TEMPORAL_SAMPLER_WEIGHTED_H_
+
+#include "../../general/util.h"
+#include "../../config.h"
+
+namespace mui {
+
+template<class DERIVED, typename CONFIG=default_config> class temporal_sampler_weighted {
+public:
+	using REAL       	= typename CONFIG::REAL;
+	using time_type  	= typename CONFIG::time_type;
+	using iterator_type = typename CONFIG::iterator_type;
+
+	//- Filter based on time input: sum(w[i]*value[i])/divisor with the weights of DERIVED::weights()
+	template<typename TYPE>
+	TYPE filter( time_type focus, const std::vector<std::pair<std::pair<time_type,iterator_type>, TYPE> > &points ) const {
+		std::vector<std::pair<time_type,iterator_type> > times;
+		std::vector<REAL> w;
+		times.reserve(points.size());
+		for( auto& i: points ) times.push_back(i.first);
+
+		REAL divisor = static_cast<const DERIVED&>(*this).weights( focus, times, w );
+		TYPE sum = TYPE(0);
+		for( size_t i = 0; i < points.size(); i++ ) {
+			if ( w[i] != REAL(0) ) sum += points[i].second * w[i];
+		}
+
+		return sum / divisor;
+	}
+
+	//- Filter based on time and iterator input - only time used
+	template<typename TYPE>
+	TYPE filter( std::pair<time_type,iterator_type> focus, const std::vector<std::pair<std::pair<time_type,iterator_type>, TYPE> > &points ) const {
+		return filter( focus.first, points );
+	}
+};
+
+}
+
+#endif /* MUI_TEMPORAL_SAMPLER_WEIGHTED_H_ */
@@ -0,0 +1,98 @@
+/*****************************************************************************
+* Multiscale Universal Interface Code Coupling Library                       *
+*                                                                            *
+* Copyright (C) 2019 Y. H. Tang, S. Kudo, X. Bian, Z. Li, G. E. Karniadakis  *
+*                                                                            *
+* This software is jointly licensed under the Apache License, Version 2.0    *
+* and the GNU General Public License version 3, you may use it according     *
+* to either.                                                                 *
+*                                                                            *
+* ** Apache License, version 2.0 **                                          *
+*                                                                            *
+* Licensed under the Apache License, Version 2.0 (the "License");            *
+* you may not use this file except in compliance with the License.           *
+* You may obtain a copy of the License at                                    *
+*                                                                            *
+* http://www.apache.org/licenses/LICENSE-2.0                                 *
+*                                                                            *
+* Unless required by applicable law or agreed to in writing, software        *
+* distributed under the License is distributed on an "AS IS" BASIS,          *
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   *
+* See the License for the specific language governing permissions and        *
+* limitations under the License.                                             *
+*                                                                            *
+* ** GNU General Public License, version 3 **                                *
+*                                                                            *
+* This program is free software: you can redistribute it and/or modify       *
+* it under the terms of the GNU General Public License as published by       *
+* the Free Software Foundation, either version 3 of the License, or          *
+* (at your option) any later version.                                        *
+*                                                                            *
+* This program is distributed in the hope that it will be useful,            *
+* but WITHOUT ANY WARRANTY; without even the implied warranty of             *
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the              *
+* GNU General Public License for more details.                               *
+*                                                                            *
+* You should have received a copy of the GNU General Public License          *
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.      *
+******************************************************************************/
+
+/**
+ * @file temporal_sampler_predictor.cpp
+ * @author MUI Development Team
+ * @date 18 October 2026
+ * @brief Unit test on the predictor and corrector temporal samplers.
+ */
+
+#include <iostream>
+#include <cmath>
+#include "../../../config.h"
+#include "../temporal_sampler_predictor.h"
+
+using config = mui::one_dim;
+using REAL = config::REAL;
+using time_type = config::time_type;
+using times_type = std::vector<std::pair<time_type,config::iterator_type> >;
+
+// f(t) = t^2 combined with the weights of sampler at focus over the frames at times
+template<class SAMPLER>
+REAL apply( const SAMPLER& sampler, time_type focus, const times_type& times ) {
+	std::vector<REAL> w;
+	REAL divisor = sampler.weights( focus, times, w );
+	REAL sum = 0;
+	for( size_t i = 0; i < times.size(); i++ ) sum += w[i] * times[i].first * times[i].first;
+	return sum / divisor;
+}
+
+bool check( const char* name, REAL value, REAL expected ) {
+	bool ok = std::abs( value - expected ) < 1e-12;
+	std::cout << ( ok ? "PASS " : "FAIL " ) << name << ": " << value << " (expected " << expected << ")" << std::endl;
+	return ok;
+}
+
+int main() {
+	bool ok = true;
+
+	// lag 2, order 1: at t=4 only frames 1 and 2 are committed, so the prediction extrapolates through them
+	mui::temporal_sampler_predictor<config> predictor( 2, 4, 1 );
+	mui::temporal_sampler_corrector<config> corrector = predictor.corrector();
+
+	const times_type committed = { {1,0}, {2,0} };
+	const times_type landed = { {1,0}, {2,0}, {3,0}, {4,0} };
+
+	const REAL prediction = apply( predictor, 4, committed );
+	ok &= check( "prediction at 4", prediction, 10 );
+
+	// frame 3 has landed meanwhile, the correction still removes the prediction through frames 1 and 2
+	const REAL correction = apply( corrector, 4, landed );
+	ok &= check( "correction at 4", correction, 6 );
+	ok &= check( "corrected value at 4", prediction + correction, 16 );
+
+	// nothing to correct where the predictor did not extrapolate
+	ok &= check( "correction at 3", apply( corrector, 3, landed ), 0 );
+
+	// the frame at the focus has landed, the predictor interpolates
+	ok &= check( "prediction at 3", apply( predictor, 3, landed ), 9 );
+
+	return ok ? 0 : 1;
+}
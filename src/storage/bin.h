@@ -51,6 +51,14 @@
 #include "../geometry/geometry.h"
 #include "../config.h"
 
+// OpenMP directives are only emitted when compiling with OpenMP, so that
+// builds without it do not warn about unknown pragmas
+#ifdef _OPENMP
+#define MUI_OMP_PRAGMA(x) _Pragma(#x)
+#else
+#define MUI_OMP_PRAGMA(x)
+#endif
+
 namespace mui {
 
 namespace {
@@ -96,6 +104,47 @@ struct count_iterator : std::iterator<std::random_access_iterator_tag,INT,INT,IN
 	}
 };
 
+// morton_: interleaves the bits of D quantised coordinates into a Z-order key.
+// Each coordinate must lie in [0,max_coord].
+template<int D> struct morton_ {
+	static const int bits = 64/D;
+	static const std::uint64_t max_coord = (std::uint64_t(1)<<bits)-1u;
+	static std::uint64_t encode( const std::uint64_t q[] ) {
+		std::uint64_t key = 0;
+		for( int b=bits-1; b>=0; --b )
+			for( int i=0; i<D; ++i ) key = (key<<1u)|((q[i]>>b)&1u);
+		return key;
+	}
+};
+template<> struct morton_<1> {
+	static const std::uint64_t max_coord = (std::uint64_t(1)<<52)-1u;
+	static std::uint64_t encode( const std::uint64_t q[] ) { return q[0]; }
+};
+template<> struct morton_<2> {
+	static const std::uint64_t max_coord = 0xffffffffull;
+	static std::uint64_t spread( std::uint64_t x ) {
+		x = (x | (x << 16u)) & 0x0000ffff0000ffffull;
+		x = (x | (x << 8u))  & 0x00ff00ff00ff00ffull;
+		x = (x | (x << 4u))  & 0x0f0f0f0f0f0f0f0full;
+		x = (x | (x << 2u))  & 0x3333333333333333ull;
+		x = (x | (x << 1u))  & 0x5555555555555555ull;
+		return x;
+	}
+	static std::uint64_t encode( const std::uint64_t q[] ) { return (spread(q[1])<<1u)|spread(q[0]); }
+};
+template<> struct morton_<3> {
+	static const std::uint64_t max_coord = 0x1fffffull;
+	static std::uint64_t spread( std::uint64_t x ) {
+		x = (x | (x << 32u)) & 0x001f00000000ffffull;
+		x = (x | (x << 16u)) & 0x001f0000ff0000ffull;
+		x = (x | (x << 8u))  & 0x100f00f00f00f00full;
+		x = (x | (x << 4u))  & 0x10c30c30c30c30c3ull;
+		x = (x | (x << 2u))  & 0x1249249249249249ull;
+		return x;
+	}
+	static std::uint64_t encode( const std::uint64_t q[] ) { return (spread(q[2])<<2u)|(spread(q[1])<<1u)|spread(q[0]); }
+};
+
 template<typename INT>
 count_iterator<INT>  operator+(INT n, count_iterator<INT> rhs) { return count_iterator<INT>(rhs.cur_+n); }
 template<int depth> struct set_map_{
@@ -230,25 +279,102 @@ private:
 	std::size_t n[CONFIG::D];
 	typename CONFIG::REAL h;
 	using REAL = typename CONFIG::REAL;
+
+	static const std::int64_t BLOCK_SIZE = 65536; // points per block in the bounding box reduction
 public:
 	template<typename T>
 	bin_t( std::vector<std::pair<point_type,T> >& val ){
-		if( val.empty() ){
+		const std::vector<std::pair<std::uint64_t,std::size_t> > order = sort_(val.size(), [&val](std::size_t k) -> const point_type& { return val[k].first; });
+
+		const std::int64_t np = static_cast<std::int64_t>(val.size());
+		std::vector<std::pair<point_type,T> > v(np);
+		MUI_OMP_PRAGMA(omp parallel for schedule(static))
+		for( std::int64_t k=0; k<np; ++k ) v[k] = std::move(val[order[k].second]);
+		v.swap(val);
+	}
+
+	// Builds the bins over a bare point array. The points are reordered in place and
+	// perm[k] receives the original position of the point now stored at k.
+	bin_t( std::vector<point_type>& pts, std::vector<std::size_t>& perm ){
+		const std::vector<std::pair<std::uint64_t,std::size_t> > order = sort_(pts.size(), [&pts](std::size_t k) -> const point_type& { return pts[k]; });
+
+		const std::int64_t np = static_cast<std::int64_t>(pts.size());
+		std::vector<point_type> v(np);
+		perm.resize(np);
+		MUI_OMP_PRAGMA(omp parallel for schedule(static))
+		for( std::int64_t k=0; k<np; ++k ) {
+			perm[k] = order[k].second;
+			v[k] = pts[order[k].second];
+		}
+		v.swap(pts);
+	}
+
+	std::vector<std::size_t> query( const geometry::box<CONFIG>& bx ) const {
+		std::vector<std::size_t> map;
+		int lda[D];
+		int lh[D][2];
+		if( initialize_query_(bx,lda,lh) ) return map;
+		map.reserve(lda[D-1]*12);
+		set_map_<D-1>::apply( 0, lda, lh, displs, map );
+		return map;
+	}
+
+	template<typename T>
+	bin_range<T,CONFIG> query2( const geometry::box<CONFIG>& bx, const std::vector<std::pair<point_type,T> >& v ) const {
+		int lda[D];
+		int lh[D][2];
+		initialize_query_(bx,lda,lh);
+		return bin_range<T,CONFIG>{lda,lh,displs,v};
+	}
+
+	REAL domain_size() const {
+		REAL dim_size = norm(max-min);
+		// Special case if domain only contains a single point
+		if(dim_size == 0) dim_size = 1.0;
+		return dim_size;
+	}
+
+private:
+	// sort_: counting sort of the points into their bins, Z-ordered within each bin.
+	// Returns (key, original position) for every point in its new position.
+	template<typename GET>
+	std::vector<std::pair<std::uint64_t,std::size_t> > sort_( std::size_t size, GET get ){
+		std::vector<std::pair<std::uint64_t,std::size_t> > order;
+		if( size == 0 ){
 			displs.resize(2,0);
 			h = 1.0;
-			return;
+			return order;
 		}
 
-		// calculate h & n
-		min = max = val[0].first;
-		for( std::size_t i=1; i<val.size(); ++i ){
-			point_type p = val[i].first;
-			for( std::size_t i=0; i<D; ++i ) {
-				min[i] = std::min(min[i],p[i]);
-				max[i] = std::max(max[i],p[i]);
+		const std::int64_t np = static_cast<std::int64_t>(size);
+
+		// calculate bounding box, reduced over fixed size blocks so that the scan can run in parallel
+		const std::int64_t nblk = (np+BLOCK_SIZE-1)/BLOCK_SIZE;
+		std::vector<point_type> bmin(nblk), bmax(nblk);
+		MUI_OMP_PRAGMA(omp parallel for schedule(static))
+		for( std::int64_t b=0; b<nblk; ++b ){
+			const std::int64_t end = std::min(np, (b+1)*BLOCK_SIZE);
+			point_type lmin = get(b*BLOCK_SIZE), lmax = lmin;
+			for( std::int64_t k=b*BLOCK_SIZE+1; k<end; ++k ){
+				const point_type& p = get(k);
+				for( int i=0; i<D; ++i ) {
+					lmin[i] = std::min(lmin[i],p[i]);
+					lmax[i] = std::max(lmax[i],p[i]);
+				}
+			}
+			bmin[b] = lmin;
+			bmax[b] = lmax;
+		}
+		min = bmin[0];
+		max = bmax[0];
+		for( std::int64_t b=1; b<nblk; ++b ){
+			for( int i=0; i<D; ++i ) {
+				min[i] = std::min(min[i],bmin[b][i]);
+				max[i] = std::max(max[i],bmax[b][i]);
 			}
 		}
 
+		// calculate h & n
 		size_t zero_count=0;
 		REAL vol = std::abs(max[0]-min[0]);
 		if(almost_equal(vol, static_cast<REAL>(0))) { // check if first dimension is zero size, if so set to 1
@@ -269,11 +395,11 @@ public:
 		if (zero_count == D) // if each dimension was actually zero (rather than just a subset) then set vol to zero
 			vol = static_cast<REAL>(0);
 
-		h = std::pow(static_cast<REAL>(6)*vol/static_cast<REAL>(val.size()),1.0/D); // about 6 points per bin
+		h = std::pow(static_cast<REAL>(6)*vol/static_cast<REAL>(size),1.0/D); // about 6 points per bin
 
 		if(almost_equal(h, static_cast<REAL>(0))){ // if h is still zero (only in the case of all dimensions being zero) then warn the user as this may be a problem
 			h = static_cast<REAL>(1); // in this special case set h to 1 arbitrarily so bins work numerically
-			if(val.size() > 1 && !QUIET)
+			if(size > 1 && !QUIET)
 				std::cout << "MUI Warning [bin.h]: Bin support size fixed to 1.0, check interface dimensionality or problem decomposition." << std::endl;
 		}
 
@@ -285,47 +411,43 @@ public:
 		}
 
 		// make index
-		std::vector<std::size_t> index(val.size()+1,0);
+		std::vector<std::size_t> index(np);
 		std::vector<std::size_t> counts(nn,0);
-		for( std::size_t i=0; i<val.size(); ++i ) {
-			index[i] = get_index_(val[i].first);
-			++counts[index[i]];
+		MUI_OMP_PRAGMA(omp parallel for schedule(static))
+		for( std::int64_t k=0; k<np; ++k ) {
+			index[k] = get_index_(get(k));
+			MUI_OMP_PRAGMA(omp atomic)
+			++counts[index[k]];
 		}
 		displs.resize(nn+1,0); // add 1 for sentinel
 		std::partial_sum(counts.begin(),counts.end(), displs.begin()+1);
 
-		counts = displs;
-		std::vector<std::pair<point_type,T> > v(val.size());
-		for( std::size_t i=0; i<val.size(); ++i ) v[counts[index[i]]++] = val[i];
-		v.swap(val);
-	}
-
-	std::vector<std::size_t> query( const geometry::box<CONFIG>& bx ) const {
-		std::vector<std::size_t> map;
-		int lda[D];
-		int lh[D][2];
-		if( initialize_query_(bx,lda,lh) ) return map;
-		map.reserve(lda[D-1]*12);
-		set_map_<D-1>::apply( 0, lda, lh, displs, map );
-		return map;
-	}
+		// counting sort on the bin index, carrying the Z-order key of each point along with its original position
+		// the scale is kept in double: max_coord does not fit a float, which rounds it up past the key range
+		double zscale[D];
+		for( int i=0; i<D; ++i )
+			zscale[i] = (max[i] > min[i]) ? static_cast<double>(morton_<D>::max_coord)/static_cast<double>(max[i]-min[i]) : 0.0;
+
+		order.resize(np);
+		std::copy(displs.begin(), displs.end()-1, counts.begin());
+		MUI_OMP_PRAGMA(omp parallel for schedule(static))
+		for( std::int64_t k=0; k<np; ++k ) {
+			std::size_t pos;
+			MUI_OMP_PRAGMA(omp atomic capture)
+			pos = counts[index[k]]++;
+			order[pos] = std::make_pair(get_zkey_(get(k), zscale), static_cast<std::size_t>(k));
+		}
 
-	template<typename T>
-	bin_range<T,CONFIG> query2( const geometry::box<CONFIG>& bx, const std::vector<std::pair<point_type,T> >& v ) const {
-		int lda[D];
-		int lh[D][2];
-		initialize_query_(bx,lda,lh);
-		return bin_range<T,CONFIG>{lda,lh,displs,v};
-	}
+		// Z-order the points of each bin so neighbouring points share cache lines; ties are
+		// broken on the original position so the result never depends on thread scheduling
+		const std::int64_t nbins = static_cast<std::int64_t>(nn);
+		MUI_OMP_PRAGMA(omp parallel for schedule(dynamic,1024))
+		for( std::int64_t b=0; b<nbins; ++b )
+			sort_bin_(order.begin()+displs[b], order.begin()+displs[b+1]);
 
-	REAL domain_size() {
-		REAL dim_size = norm(max-min);
-		// Special case if domain only contains a single point
-		if(dim_size == 0) dim_size = 1.0;
-		return dim_size;
+		return order;
 	}
 
-private:
 	bool initialize_query_( const geometry::box<CONFIG>& bx, int lda[], int lh[][2] ) const {
 		bool broken = false;
 		lda[0] = 1;
@@ -341,6 +463,24 @@ private:
 		return broken;
 	}
 
+	template<typename ITER>
+	static void sort_bin_( ITER first, ITER last ) {
+		if( last-first > 32 ) { std::sort(first, last); return; }
+		// bins hold about 6 points, where insertion sort beats std::sort
+		for( ITER i=first; i!=last; ++i )
+			for( ITER j=i; j!=first && *j < *(j-1); --j ) std::iter_swap(j, j-1);
+	}
+
+	inline std::uint64_t get_zkey_( const point_type& pt, const double zscale[] ) const {
+		std::uint64_t q[D];
+		for( int i=0; i<D; ++i ) {
+			const double x = static_cast<double>(pt[i]-min[i])*zscale[i];
+			// rounding may still put the largest coordinate a step past the key range
+			q[i] = (x >= static_cast<double>(morton_<D>::max_coord)) ? morton_<D>::max_coord : static_cast<std::uint64_t>(x);
+		}
+		return morton_<D>::encode(q);
+	}
+
 	inline std::size_t get_index_( const point_type& pt ) const {
 		std::size_t m = 1, ret=0;
 		for( int i=0; i<D; ++i ) {
@@ -107,33 +107,85 @@ template<typename Head, typename... Tail> struct get_head_ { typedef Head type;
 template<typename... Types>
 using get_head_t_ = typename get_head_<Types...>::type;
 
-// type dispatcher. 
-template<id_t i, typename R, typename... Args> struct apply_visitor_impl_;
-template<id_t i, typename R, typename Head, typename... Tail>
-struct apply_visitor_impl_<i,R,Head,Tail...> {
+// throwing from a function of its own keeps the dispatchers below small
+// enough to inline
+[[noreturn]] inline void throw_bad_id_() { throw bad_storage_id("MUI Error [dynstorage.h]: Storage error, bad id."); }
+
+// k-th type of a list, or none_ past its end
+struct none_ {};
+template<std::size_t k, typename... Types> struct type_at_ { typedef none_ type; };
+template<typename Head, typename... Tail> struct type_at_<0,Head,Tail...> { typedef Head type; };
+template<std::size_t k, typename Head, typename... Tail> struct type_at_<k,Head,Tail...> { typedef typename type_at_<k-1,Tail...>::type type; };
+
+// type dispatcher. visits go through a single switch on the type id, which
+// the compiler lowers to a jump table with each case inlined. ids past the
+// switch are passed on to the list without its head.
+template<typename R, typename... Types> struct applyer_;
+template<typename R> struct applyer_<R> {
 	template<typename F>
-	static R apply( id_t which, void* content, F& f ) { // this applies the content to f
-		if( i == which ) return f(*static_cast<Head*>(content));
-		else return apply_visitor_impl_<i+1,R,Tail...>::apply(which,content,f);
-	}
+	static R apply( std::int32_t, const void*, F& ) { throw_bad_id_(); }
 	template<typename F>
-	static R apply( id_t which, const void* content, F& f ) {
-		if( i == which ) return f(*static_cast<const Head*>(content));
-		else return apply_visitor_impl_<i+1,R,Tail...>::apply(which,content,f);
+	static R applym( std::int32_t, void*, F& )      { throw_bad_id_(); }
+};
+template<typename R, typename Head, typename... Tail> struct applyer_<R,Head,Tail...> {
+	template<typename T, typename F> struct call_ {
+		static R apply( void* content, F& f )       { return f(*static_cast<T*>(content)); }
+		static R apply( const void* content, F& f ) { return f(*static_cast<const T*>(content)); }
+		static R applym( void* content, F& f )      { return f(std::move(*static_cast<T*>(content))); }
+	};
+	template<typename F> struct call_<none_,F> {
+		static R apply( const void*, F& ) { throw_bad_id_(); }
+		static R applym( void*, F& )      { throw_bad_id_(); }
+	};
+	template<std::size_t k, typename F> using at_ = call_<typename type_at_<k,Head,Tail...>::type,F>;
+
+	template<typename F, typename P>
+	static R apply( std::int32_t which, P content, F& f ) { // this applies the content to f
+		switch( which ) {
+		case 0: return at_<0,F>::apply(content,f);
+		case 1: return at_<1,F>::apply(content,f);
+		case 2: return at_<2,F>::apply(content,f);
+		case 3: return at_<3,F>::apply(content,f);
+		case 4: return at_<4,F>::apply(content,f);
+		case 5: return at_<5,F>::apply(content,f);
+		case 6: return at_<6,F>::apply(content,f);
+		case 7: return at_<7,F>::apply(content,f);
+		default: return applyer_<R,Tail...>::apply(which-1,content,f);
+		}
 	}
 	template<typename F>
-	static R applym( id_t which, void* content, F& f ) { // move the content to f
-		if( i == which ) return f(std::move(*static_cast<Head*>(content)));
-		else return apply_visitor_impl_<i+1,R,Tail...>::applym(which,content,f);
+	static R applym( std::int32_t which, void* content, F& f ) { // move the content to f
+		switch( which ) {
+		case 0: return at_<0,F>::applym(content,f);
+		case 1: return at_<1,F>::applym(content,f);
+		case 2: return at_<2,F>::applym(content,f);
+		case 3: return at_<3,F>::applym(content,f);
+		case 4: return at_<4,F>::applym(content,f);
+		case 5: return at_<5,F>::applym(content,f);
+		case 6: return at_<6,F>::applym(content,f);
+		case 7: return at_<7,F>::applym(content,f);
+		default: return applyer_<R,Tail...>::applym(which-1,content,f);
+		}
 	}
 };
-template<id_t i, typename R> struct apply_visitor_impl_<i,R> {
+// a config with a single data type has nothing to dispatch on
+template<typename R, typename T> struct applyer_<R,T> {
 	template<typename F>
-	static R apply( id_t, const void*, F& ) { throw bad_storage_id("MUI Error [dynstorage.h]: Storage error, bad id."); }
+	static R apply( std::int32_t which, void* content, F& f ) {
+		if( which != 0 ) throw_bad_id_();
+		return f(*static_cast<T*>(content));
+	}
+	template<typename F>
+	static R apply( std::int32_t which, const void* content, F& f ) {
+		if( which != 0 ) throw_bad_id_();
+		return f(*static_cast<const T*>(content));
+	}
 	template<typename F>
-	static R applym( id_t, void*, F& )      { throw bad_storage_id("MUI Error [dynstorage.h]: Storage error, bad id."); }
+	static R applym( std::int32_t which, void* content, F& f ) {
+		if( which != 0 ) throw_bad_id_();
+		return f(std::move(*static_cast<T*>(content)));
+	}
 };
-template<typename R,typename... Types> using applyer_ = apply_visitor_impl_<0,R,Types...>;
 }
 
 // storage can hold any type of Types... and it has value semantics.
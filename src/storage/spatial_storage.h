@@ -46,69 +46,198 @@
 
 #define SPATIAL_STORAGE_H
 
+#include <algorithm>
 #include <exception>
+#include <memory>
 #include <mutex>
 #include "dynstorage.h"
 #include "virtual_container.h"
 
 namespace mui {
 
+// spatial_index: the immutable part of a frame. It holds the points in bin order and the
+// bins built over them, and is shared by every frame that carries the same point set.
+template<typename BIN, typename CONFIG>
+struct spatial_index {
+	using point_type = typename CONFIG::point_type;
+	using source_type = std::shared_ptr<const std::vector<point_type> >;
+
+	spatial_index( std::vector<point_type> pts, std::vector<source_type> src, std::vector<std::size_t> cnt )
+		: points(std::move(pts)), bin(points, order), sources(std::move(src)), counts(std::move(cnt)) {
+		if( counts.size() < 2 ) return;
+		std::vector<std::size_t> offsets(1, 0);
+		for( std::size_t n: counts ) offsets.push_back(offsets.back() + n);
+		chunk.resize(order.size());
+		local.resize(order.size());
+		for( std::size_t k=0; k<order.size(); ++k ) {
+			const std::size_t c = std::upper_bound(offsets.begin(), offsets.end(), order[k]) - offsets.begin() - 1;
+			chunk[k] = static_cast<std::uint32_t>(c);
+			local[k] = order[k] - offsets[c];
+		}
+	}
+
+	std::vector<point_type> points;  // points in bin order
+	std::vector<std::size_t> order;  // points[k] came from position order[k] of the frame it was built for
+	BIN bin;
+	std::vector<source_type> sources; // shared point arrays the index was built from, if any
+	std::vector<std::size_t> counts;  // number of points from each sender, in sender order
+	// with more than one sender, points[k] is point local[k] of the chunk[k]-th sender
+	std::vector<std::uint32_t> chunk;
+	std::vector<std::size_t> local;
+};
+
+// spatial_index_cache: latest index built for an attribute, offered to new frames for reuse.
+template<typename BIN, typename CONFIG>
+class spatial_index_cache {
+public:
+	using index_type = spatial_index<BIN,CONFIG>;
+
+	std::shared_ptr<const index_type> get() const {
+		std::lock_guard<std::mutex> lock(mutex_);
+		return index_;
+	}
+	void set( std::shared_ptr<const index_type> index ) {
+		std::lock_guard<std::mutex> lock(mutex_);
+		index_ = std::move(index);
+	}
+private:
+	std::shared_ptr<const index_type> index_;
+	mutable std::mutex mutex_;
+};
+
 template<typename BIN, typename STORAGE, typename CONFIG>
 class spatial_storage {
 private: // type definitions
 	using storage_t = STORAGE;
+	template<typename T> struct def_values_;
+	template<typename... TYPES> struct def_values_<type_list<TYPES...> >{
+		using type = storage<std::vector<TYPES>...>;
+	};
 public:
 	using point_type = typename CONFIG::point_type;
 	using EXCEPTION = typename CONFIG::EXCEPTION;
+	using values_t = typename def_values_<typename CONFIG::data_types>::type;
+	using index_type = spatial_index<BIN,CONFIG>;
+	using cache_type = spatial_index_cache<BIN,CONFIG>;
+	using source_type = typename index_type::source_type;
 
-private: // functors
-	struct insert_ { 
-		template<typename T> void operator()( T& t ){
-			T& rhs = storage_cast<T&>(st);
-			t.insert(t.end(), std::make_move_iterator(rhs.begin()), std::make_move_iterator(rhs.end()));
+private: // internal types & functors
+	// data received from one sender; values[i] belongs to (*points)[i], trailing points
+	// without a value are ignored. points is released once an index covers it
+	struct chunk_ {
+		std::int32_t sender;
+		source_type points;
+		values_t values;
+	};
+	struct split_ {
+		template<typename T> void operator()( std::vector<std::pair<point_type,T> >& v ){
+			std::vector<point_type> pts(v.size());
+			std::vector<T> vals(v.size());
+			for( std::size_t i=0; i<v.size(); ++i ) {
+				pts[i] = v[i].first;
+				vals[i] = std::move(v[i].second);
+			}
+			points = std::make_shared<const std::vector<point_type> >(std::move(pts));
+			values = values_t(std::move(vals));
+		}
+		source_type& points;
+		values_t& values;
+	};
+	struct size_ {
+		template<typename T> std::size_t operator()( const std::vector<T>& t ){ return t.size(); }
+	};
+	// reads a vector of point-value pairs into separate point and value arrays
+	struct split_reader_ {
+		template<typename T> values_t operator()( std::vector<T>&& vals ){
+			std::size_t n;
+			stream >> n;
+			std::vector<point_type> pts(n);
+			vals.resize(n);
+			for( std::size_t i=0; i<n; ++i ) stream >> pts[i] >> vals[i];
+			points = std::make_shared<const std::vector<point_type> >(std::move(pts));
+			return values_t(std::move(vals));
 		}
-		storage_t st;
+		istream& stream;
+		source_type& points;
 	};
-	struct construct_ {
-		template<typename T> void operator()(T& t){ ::new(ptr) BIN(t); }
-		void* ptr;
+	template<typename T> struct read_split_;
+	template<typename... TYPES> struct read_split_<type_list<TYPES...> >{
+		static values_t apply( std::int32_t which, istream& stream, source_type& points ) {
+			return make_value_<0,values_t,std::vector<TYPES>...>::apply(which, split_reader_{stream, points});
+		}
 	};
 public:
+	// the values of one attribute from one sender as they travel in a commit.
+	// the sender fills pairs; reading one off a stream decodes the same bytes
+	// straight into the point and value arrays that insert() then keeps.
+	struct transfer_type {
+		transfer_type() = default;
+		explicit transfer_type( storage_t st ) : pairs(std::move(st)) {}
+
+		storage_t pairs;
+		source_type points;
+		values_t values;
+
+		friend ostream& operator<<( ostream& stream, const transfer_type& t ) {
+			if( !t.values ) return stream << t.pairs;
+			stream << t.values.which();
+			t.values.apply_visitor(split_writer_{stream, *t.points});
+			return stream;
+		}
+		friend istream& operator>>( istream& stream, transfer_type& t ) {
+			std::int32_t which;
+			stream >> which;
+			t = transfer_type();
+			if( which != storage_t::bad_id )
+				t.values = read_split_<typename CONFIG::data_types>::apply(which, stream, t.points);
+			return stream;
+		}
+	private:
+		struct split_writer_ {
+			template<typename T> void operator()( const std::vector<T>& vals ){
+				stream << vals.size();
+				for( std::size_t i=0; i<vals.size(); ++i ) stream << pts[i] << vals[i];
+			}
+			ostream& stream;
+			const std::vector<point_type>& pts;
+		};
+	};
+
 	spatial_storage() noexcept {
-		is_bin_ = false;
+		is_built_ = false;
+	}
+	spatial_storage( const spatial_storage& rhs ): chunks_(rhs.chunks_), index_(rhs.index_), cache_(rhs.cache_) {
+		is_built_.store(rhs.is_built_.load());
 	}
-	~spatial_storage() {
-		destroy_if_bin_();
+	spatial_storage( spatial_storage&& rhs ) noexcept : chunks_(std::move(rhs.chunks_)), index_(std::move(rhs.index_)),
+	                                                     cache_(std::move(rhs.cache_)) {
+		is_built_.store(rhs.is_built_.load());
+		rhs.is_built_ = false;
 	}
-	spatial_storage( const spatial_storage& rhs ): data_(rhs.data_) {
-		is_bin_.store(rhs.is_bin_.load());
-		if( rhs.is_built() ) ::new(&bin_) BIN(rhs.bin_);
+	spatial_storage( std::int32_t sender, storage_t rhs, std::shared_ptr<cache_type> cache = std::shared_ptr<cache_type>() ): cache_(std::move(cache)) {
+		is_built_ = false;
+		insert(sender, std::move(rhs));
 	}
-	spatial_storage( spatial_storage&& rhs ) noexcept : data_(std::move(rhs.data_)) {
-		is_bin_.store(rhs.is_bin_.load());
-		if( rhs.is_built() ) ::new(&bin_) BIN(std::move(rhs.bin_));
-		rhs.destroy_if_bin_();
+	spatial_storage( std::int32_t sender, source_type points, values_t values, std::shared_ptr<cache_type> cache = std::shared_ptr<cache_type>() ): cache_(std::move(cache)) {
+		is_built_ = false;
+		insert(sender, std::move(points), std::move(values));
 	}
-	spatial_storage( storage_t rhs ): data_(std::move(rhs)) {
-		is_bin_ = false;
+	spatial_storage( std::int32_t sender, transfer_type rhs, std::shared_ptr<cache_type> cache = std::shared_ptr<cache_type>() ): cache_(std::move(cache)) {
+		is_built_ = false;
+		insert(sender, std::move(rhs));
 	}
 	spatial_storage& operator=( spatial_storage rhs ) {
 		rhs.swap(*this);
 		return *this;
 	}
 	
-	void swap( spatial_storage& rhs ) noexcept(noexcept(BIN(std::move(rhs.bin_)))) {
-		data_.swap(rhs.data_);
-		if( is_bin_ && rhs.is_bin_ ) bin_.swap(rhs.bin_);
-		else if( is_bin_ && !rhs.is_bin_ ) {
-			::new(&(rhs.bin_)) BIN(std::move(bin_));
-			rhs.is_bin_ = true;
-			destroy_if_bin_();
-		} else if( !is_bin_ && rhs.is_bin_ ) {
-			::new(&(bin_)) BIN(std::move(rhs.bin_));
-			is_bin_ = true;
-			rhs.destroy_if_bin_();
-		}
+	void swap( spatial_storage& rhs ) noexcept {
+		chunks_.swap(rhs.chunks_);
+		index_.swap(rhs.index_);
+		cache_.swap(rhs.cache_);
+		bool built = is_built_;
+		is_built_.store(rhs.is_built_.load());
+		rhs.is_built_ = built;
 	}
 
 	// no lock internally; it's job of uniface because
@@ -116,69 +245,191 @@ public:
 	template<typename REGION, typename FOCUS, typename SAMPLER, typename ... ADDITIONAL>
 	typename SAMPLER::OTYPE
 	query(const REGION& reg, const FOCUS& f, SAMPLER& s, ADDITIONAL && ... additional) const {
-		using vec = std::vector<std::pair<point_type,typename SAMPLER::ITYPE> >;
+		using ITYPE = typename SAMPLER::ITYPE;
 
-		if( data_.empty() )
-			return s.filter( f, virtual_container<typename SAMPLER::ITYPE,CONFIG>(vec(), std::vector<bool>()), additional... );
+		if( empty() ) {
+			static const std::vector<point_type> no_points;
+			static const std::vector<ITYPE> no_values;
+			return s.filter( f, virtual_container<ITYPE,CONFIG>(no_points, no_values, 0, std::vector<std::size_t>()), additional... );
+		}
 		if( !is_built() ) EXCEPTION(std::logic_error("MUI Error [spatial_storage.h]: Query error, "
 				                                         "bin structure not built yet."));
 
-		const vec& st = storage_cast<const vec&>(data_);
-
-		return s.filter( f, virtual_container<typename SAMPLER::ITYPE,CONFIG>(st, bin_.query(reg)), additional...);
+		if( chunks_.size() == 1 )
+			return s.filter( f, virtual_container<ITYPE,CONFIG>(index_->points, values<ITYPE>(0), &index_->order, index_->bin.query(reg)), additional...);
+		return s.filter( f, virtual_container<ITYPE,CONFIG>(index_->points, chunk_values<ITYPE>(), &index_->chunk, &index_->local, index_->bin.query(reg)), additional...);
 	}
 
 	void build() {
 		if( is_built() ) EXCEPTION(std::logic_error("MUI Error [spatial_storage.h]: Build error, cannot build bin structure twice."));
-		if( !data_.empty() ) {
-		  data_.apply_visitor(construct_{static_cast<void*>(&bin_)});
-			is_bin_ = true;
+		if( chunks_.empty() ) return;
+
+		// concatenate in sender order so that the layout does not depend on message arrival
+		std::stable_sort(chunks_.begin(), chunks_.end(), [](const chunk_& a, const chunk_& b) { return a.sender < b.sender; });
+
+		std::shared_ptr<const index_type> hint;
+		if( cache_ ) hint = cache_->get();
+		if( hint && matches_(*hint) ) index_ = std::move(hint);
+		else {
+			std::vector<source_type> sources;
+			std::vector<point_type> pts;
+			for( const chunk_& c: chunks_ ) {
+				sources.push_back(c.points);
+				pts.insert(pts.end(), c.points->begin(), c.points->begin()+c.values.apply_visitor(size_()));
+			}
+			index_ = std::make_shared<const index_type>(std::move(pts), std::move(sources), counts_());
+			if( cache_ ) cache_->set(index_);
 		}
+
+		// the index now holds the points, so drop the per-frame copies it does not share
+		for( chunk_& c: chunks_ )
+			if( std::find(index_->sources.begin(), index_->sources.end(), c.points) == index_->sources.end() ) c.points.reset();
+
+		is_built_ = true;
 	}
 
 	template<typename FOCUS, typename SAMPLER, typename ...ADDITIONAL>
 	typename SAMPLER::OTYPE
 	build_and_query_ts(const FOCUS& f, SAMPLER& s, ADDITIONAL && ... additional) {
-		// this method is thread-safe. other methods are not.
-		{
-			std::unique_lock<std::mutex> lock(mutex_);
-			if( !is_built() ) build();
-		}
+		build_ts();
+		const typename CONFIG::REAL domain_size = is_built() ? index_->bin.domain_size() : typename CONFIG::REAL(1);
+		return query(s.support(f, domain_size).bbox(), f, s, additional...);
+	}
 
-		return query(s.support(f, bin_.domain_size()).bbox(), f, s, additional...);
+	void build_ts() {
+		// this method is thread-safe. other methods are not.
+		std::unique_lock<std::mutex> lock(mutex_);
+		if( !is_built() ) build();
 	}
 
-	void insert( storage_t storage ) {
-		destroy_if_bin_();
+	void insert( std::int32_t sender, storage_t storage ) {
 		if( !storage ) return;
-		if( !data_ ) data_ = std::move(storage);
-		else if( data_.which() == storage.which() ) data_.apply_visitor(insert_{storage});
-		else EXCEPTION(bad_storage_id("MUI Error [spatial_storage.h]: Insert error. Type doesn't match."));
+		chunk_ c;
+		c.sender = sender;
+		storage.apply_visitor(split_{c.points, c.values});
+		insert_chunk_(std::move(c));
 	}
 
-	template<typename TYPE>
-	const std::vector<std::pair<point_type,TYPE> >& return_data() {
-		return storage_cast<const std::vector<std::pair<point_type,TYPE> >& >(data_);
+	void insert( std::int32_t sender, transfer_type t ) {
+		if( t.values ) insert(sender, std::move(t.points), std::move(t.values));
+		else insert(sender, std::move(t.pairs));
 	}
 
+	// values[i] belongs to (*points)[i]; the point array is shared, not copied, even when
+	// fewer values than points arrive
+	void insert( std::int32_t sender, source_type points, values_t values ) {
+		if( !values ) return;
+		const std::size_t n = values.apply_visitor(size_());
+		if( !points || n > points->size() )
+			EXCEPTION(std::length_error("MUI Error [spatial_storage.h]: Insert error. More values than points."));
+		chunk_ c;
+		c.sender = sender;
+		c.points = std::move(points);
+		c.values = std::move(values);
+		insert_chunk_(std::move(c));
+	}
+
+	/** \brief Points of the frame in bin order, the frame must have been built
+	*/
+	const std::vector<point_type>& points() const {
+		static const std::vector<point_type> no_points;
+		return is_built() ? index_->points : no_points;
+	}
+
+	/** \brief Values of the frame in the order of points(), the frame must have been built
+	*/
+	template<typename TYPE>
+	std::vector<TYPE> ordered_values() const {
+		std::vector<TYPE> ret;
+		if( !is_built() ) return ret;
+		ret.reserve(index_->order.size());
+		if( chunks_.size() == 1 ) {
+			const std::vector<TYPE>& v = values<TYPE>(0);
+			for( std::size_t k: index_->order ) ret.push_back(v[k]);
+		}
+		else {
+			const std::vector<const std::vector<TYPE>*> v = chunk_values<TYPE>();
+			for( std::size_t k=0; k<index_->order.size(); ++k ) ret.push_back((*v[index_->chunk[k]])[index_->local[k]]);
+		}
+		return ret;
+	}
 
-	bool is_built() const { return is_bin_; }
-	bool empty() const { return data_.empty(); }
+	bool is_built() const { return is_built_; }
+	bool empty() const { return chunks_.empty(); }
 private:
-	void destroy_if_bin_() { 
-		if( is_built() ) {
-			bin_.~BIN(); 
-			is_bin_ = false;
+	template<typename TYPE>
+	const std::vector<TYPE>& values( std::size_t i ) const {
+		return storage_cast<const std::vector<TYPE>&>(chunks_[i].values);
+	}
+	// value arrays of all senders, in sender order
+	template<typename TYPE>
+	std::vector<const std::vector<TYPE>*> chunk_values() const {
+		std::vector<const std::vector<TYPE>*> ret;
+		ret.reserve(chunks_.size());
+		for( std::size_t i=0; i<chunks_.size(); ++i ) ret.push_back(&values<TYPE>(i));
+		return ret;
+	}
+	std::vector<std::size_t> counts_() const {
+		std::vector<std::size_t> ret;
+		ret.reserve(chunks_.size());
+		for( const chunk_& c: chunks_ ) ret.push_back(c.values.apply_visitor(size_()));
+		return ret;
+	}
+
+	void insert_chunk_( chunk_ c ) {
+		if( !chunks_.empty() && chunks_[0].values.which() != c.values.which() )
+			EXCEPTION(bad_storage_id("MUI Error [spatial_storage.h]: Insert error. Type doesn't match."));
+		// a frame that grows after it was built is rebuilt on the next query
+		if( is_built() ) restore_points_();
+		chunks_.push_back(std::move(c));
+		is_built_ = false;
+	}
+
+	// give back the point arrays released by build(), recovering them from the index
+	void restore_points_() {
+		if( !index_ ) return;
+		std::vector<point_type> pts(index_->points.size());
+		for( std::size_t k=0; k<pts.size(); ++k ) pts[index_->order[k]] = index_->points[k];
+		std::size_t offset = 0;
+		for( chunk_& c: chunks_ ) {
+			const std::size_t n = c.values.apply_visitor(size_());
+			if( !c.points && offset+n <= pts.size() )
+				c.points = std::make_shared<const std::vector<point_type> >(pts.begin()+offset, pts.begin()+offset+n);
+			offset += n;
 		}
+		index_.reset();
 	}
 
-	storage_t data_;
+	// true if the index was built for exactly the points currently held
+	bool matches_( const index_type& idx ) const {
+		// the chunk boundaries decide where each value is read from
+		if( idx.counts != counts_() ) return false;
+		if( idx.sources.size() == chunks_.size() &&
+		    std::equal(chunks_.begin(), chunks_.end(), idx.sources.begin(),
+		               [](const chunk_& c, const source_type& src) { return c.points == src; }) )
+			return true;
 
-	std::atomic<bool> is_bin_;
-	union {
-		char nodata_ = '\0';
-		BIN bin_;
-	};
+		std::vector<const point_type*> pts;
+		for( const chunk_& c: chunks_ ) {
+			const std::size_t n = c.values.apply_visitor(size_());
+			for( std::size_t i=0; i<n; ++i ) pts.push_back(&(*c.points)[i]);
+		}
+		if( pts.size() != idx.points.size() ) return false;
+
+		for( std::size_t k=0; k<pts.size(); ++k ) {
+			const point_type& a = idx.points[k];
+			const point_type& b = *pts[idx.order[k]];
+			for( int i=0; i<CONFIG::D; ++i )
+				if( a[i] != b[i] ) return false;
+		}
+		return true;
+	}
+
+	std::vector<chunk_> chunks_;
+	std::shared_ptr<const index_type> index_;
+	std::shared_ptr<cache_type> cache_;
+
+	std::atomic<bool> is_built_;
 	mutable std::mutex mutex_;
 };
 }
@@ -65,16 +65,20 @@ struct index_iterator: public std::iterator<std::forward_iterator_tag,V>
 	typedef typename iterator::pointer pointer;
 	typedef typename iterator::reference reference;
 
-	index_iterator( ARRAY& array, std::size_t index=0 ): array_(array), index_(index) {}
+	index_iterator( ARRAY& array, std::size_t index=0 ): array_(&array), index_(index) {}
 	index_iterator() = default;
 	index_iterator( const index_iterator& ) = default;
 	index_iterator& operator=( const index_iterator& ) = default;
 
-	value_type operator*() const { return array_[index_]; }
-	reference operator*() { return array_[index_]; }
-	const pointer operator->() const { return &(array_[index_]); }
-	pointer operator->() { return &(array_[index_]); }
+	// elements are proxies built on access, so they are returned by value
+	// and operator-> hands out a pointer into a temporary copy of one
+	struct arrow_proxy {
+		value_type elem;
+		const value_type* operator->() const { return &elem; }
+	};
 
+	value_type operator*() const { return (*array_)[index_]; }
+	arrow_proxy operator->() const { return arrow_proxy{(*array_)[index_]}; }
 
 	index_iterator& operator++(){
 		++index_;
@@ -88,35 +92,56 @@ struct index_iterator: public std::iterator<std::forward_iterator_tag,V>
 	bool operator==( const index_iterator& rhs ) const { return index_ == rhs.index_; }
 	bool operator!=( const index_iterator& rhs ) const { return index_ != rhs.index_; }
 private:
-	ARRAY& array_;
+	ARRAY* array_;
 	std::size_t index_;
 };
 
 
+// virtual_container: a view of the points selected by a query. The points and the values
+// are held in separate arrays; points[k] is paired with values[order[k]], or with values[k]
+// when no order is given. Values split over several arrays are read as chunks[chunk[k]][local[k]].
+// A container of point-value pairs may be viewed as well.
 template < typename TYPE, typename CONFIG>
 class virtual_container {
 public:
-	using elem_type      = std::pair<typename CONFIG::point_type,TYPE>;
-	using container_type = std::vector<elem_type>;
+	using point_type     = typename CONFIG::point_type;
+	using elem_type      = std::pair<const point_type&,const TYPE&>;
+	using container_type = std::vector<std::pair<point_type,TYPE> >;
 	typedef index_iterator<const elem_type,const virtual_container> iterator;
 
+	inline virtual_container( const std::vector<point_type> &points, const std::vector<TYPE> &values,
+	                          const std::vector<size_t> *order, std::vector<size_t> map ) :
+		points_(points), values_(values), order_(order), chunk_(0), pairs_(0), map_(std::move(map)) {
+	}
+	virtual_container( const std::vector<point_type> &points, const std::vector<TYPE> &values,
+	                   const std::vector<size_t> *order, const std::vector<bool> &pred ) :
+		points_(points), values_(values), order_(order), chunk_(0), pairs_(0) {
+		for( size_t i = 0 ; i < pred.size() ; i++ ) if (pred[i]) map_.push_back(i);
+	}
+	inline virtual_container( const std::vector<point_type> &points, std::vector<const std::vector<TYPE>*> chunks,
+	                          const std::vector<std::uint32_t> *chunk, const std::vector<size_t> *local, std::vector<size_t> map ) :
+		points_(points), values_(no_values_()), order_(local), chunk_(chunk), chunks_(std::move(chunks)), pairs_(0), map_(std::move(map)) {
+	}
 	inline virtual_container( const container_type &container, std::vector<size_t> map ) :
-		container_(container), map_(std::move(map)) {
+		points_(no_points_()), values_(no_values_()), order_(0), chunk_(0), pairs_(&container), map_(std::move(map)) {
 	}
 	virtual_container( const container_type &container, const std::vector<bool> &pred ) :
-		container_(container) {
+		points_(no_points_()), values_(no_values_()), order_(0), chunk_(0), pairs_(&container) {
 		for( size_t i = 0 ; i < pred.size() ; i++ ) if (pred[i]) map_.push_back(i);
 	}
 
 	// operator [] does no bound check
-	inline const elem_type& operator [] ( size_t i ) const {
-		return container_[ map_[i] ];
+	inline elem_type operator [] ( size_t i ) const {
+		const size_t k = map_[i];
+		if( pairs_ ) return elem_type( (*pairs_)[k].first, (*pairs_)[k].second );
+		if( chunk_ ) return elem_type( points_[k], (*chunks_[(*chunk_)[k]])[(*order_)[k]] );
+		return elem_type( points_[k], values_[order_ ? (*order_)[k] : k] );
 	}
 
 	// at performs bound check
-	inline const elem_type& at ( size_t i ) const {
+	inline elem_type at ( size_t i ) const {
 		if ( i >= map_.size() ) typename CONFIG::EXCEPTION(std::out_of_range("MUI Error [virtual_container.h]: Out of range."));
-		return container_[ map_[i] ];
+		return operator[](i);
 	}
 
 	inline iterator begin() const {
@@ -133,13 +158,43 @@ public:
 
 	inline size_t size() const { return map_.size(); }
 protected:
-	container_type const & container_;
+	const std::vector<point_type> &points_;
+	const std::vector<TYPE> &values_;
+	const std::vector<size_t> *order_;
+	const std::vector<std::uint32_t> *chunk_;
+	std::vector<const std::vector<TYPE>*> chunks_;
+	const container_type *pairs_;
 	std::vector<size_t> map_;
 
+private:
+	static const std::vector<point_type>& no_points_() {
+		static const std::vector<point_type> none;
+		return none;
+	}
+	static const std::vector<TYPE>& no_values_() {
+		static const std::vector<TYPE> none;
+		return none;
+	}
 };
 
 template < typename TYPE, typename CONFIG>
-virtual_container<TYPE,CONFIG> make_vc( const std::vector<typename CONFIG::point_type,TYPE> &container,
+virtual_container<TYPE,CONFIG> make_vc( const std::vector<typename CONFIG::point_type> &points,
+                                        const std::vector<TYPE> &values,
+                                        const std::vector<size_t> &map )
+{
+	return virtual_container<TYPE,CONFIG>(points,values,0,map);
+}
+
+template < typename TYPE, typename CONFIG>
+virtual_container<TYPE,CONFIG> make_vc( const std::vector<typename CONFIG::point_type> &points,
+                                        const std::vector<TYPE> &values,
+                                        const std::vector<bool> &pred )
+{
+	return virtual_container<TYPE,CONFIG>(points,values,0,pred);
+}
+
+template < typename TYPE, typename CONFIG>
+virtual_container<TYPE,CONFIG> make_vc( const std::vector<std::pair<typename CONFIG::point_type,TYPE> > &container,
                                         const std::vector<size_t> &map )
 {
 	return virtual_container<TYPE,CONFIG>(container,map);
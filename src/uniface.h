@@ -52,6 +52,14 @@
 #ifndef UNIFACE_H_
 #define UNIFACE_H_
 #include <iostream>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <algorithm>
+#include <typeinfo>
+#include <list>
 
 #include "general/util.h"
 #include "communication/comm.h"
@@ -62,11 +70,13 @@
 #include "communication/lib_dispatcher.h"
 #include "communication/message/message.h"
 #include "communication/message/reader_variable.h"
+#include "communication/message/codec.h"
 #include "storage/stream_vector.h"
 #include "storage/stream_unordered.h"
 #include "storage/stream_string.h"
 #include "storage/bin.h"
 #include "storage/stream.h"
+#include "geometry/bvh.h"
 
 #ifdef PYTHON_BINDINGS
 #include <pybind11/pybind11.h>
@@ -92,6 +102,7 @@ public:
 	using data_types = typename CONFIG::data_types;
 	using span_t = geometry::any_shape<CONFIG>;
 private:
+	using EXCEPTION = typename CONFIG::EXCEPTION;
 	// meta functions to split tuple and add vector<pair<point_type,_1> >
 	template<typename T> struct add_vp_ { using type = std::vector<std::pair<point_type,T> >; };
 		template<typename T> struct def_storage_;
@@ -99,10 +110,9 @@ private:
 		using type = storage<typename add_vp_<TYPES>::type...>;
 	};
 
-	template<typename T> struct add_vi_ { using type = std::vector<std::pair<size_t, T> >; };
 	template<typename T> struct def_storage_raw_;
 	template<typename... TYPES> struct def_storage_raw_<type_list<TYPES...> >{
-		using type = storage<typename add_vi_<TYPES>::type...>;
+		using type = storage<std::vector<TYPES>...>;
 	};
 
 	template<typename T> struct def_storage_single_;
@@ -113,11 +123,17 @@ private:
 	// internal typedefinitions for full frame
 	using storage_t = typename def_storage_<data_types>::type;
 	using spatial_t = spatial_storage<bin_t<CONFIG>,storage_t,CONFIG>;
+	using index_cache_t = typename spatial_t::cache_type;
+	using points_ptr_t = typename spatial_t::source_type;
 	using frame_type = std::unordered_map<std::string, storage_t>;
+	using frame_transfer_type = std::unordered_map<std::string, typename spatial_t::transfer_type>;
 	using bin_frame_type = std::unordered_map<std::string, spatial_t>;
 	// internal typdefinitions for data values only (static points)
 	using storage_raw_t = typename def_storage_raw_<data_types>::type;
 	using frame_raw_type = std::unordered_map<std::string, storage_raw_t>;
+	using frame_pts_type = std::unordered_map<std::string, std::vector<point_type> >;
+	// internal typedefinitions for encoded frames
+	using frame_codec_type = std::unordered_map<std::string, codec_block>;
 	// internal typedefinitions for single value
 	using storage_single_t = typename def_storage_single_<data_types>::type;
 
@@ -129,6 +145,10 @@ private:
 		bool is_recving(time_type t, const span_t& s) const {
 			return scan_spans_(t,s,recving_spans);
 		}
+
+		const spans_type& recving_spans_all() const {
+			return recving_spans;
+		}
 		
 		void set_recving( time_type start, time_type end, span_t s ) {
 			recving_spans.emplace(std::make_pair(start,end),std::move(s));
@@ -142,12 +162,14 @@ private:
 			sending_spans.emplace(std::make_pair(start,end), std::move(s));
 		}
 
-		void set_pts(std::vector<point_type>& pts) {
-			pts_ = pts;
+		void set_pts(frame_pts_type& pts) {
+			for( auto& p: pts )
+				pts_[p.first] = std::make_shared<const std::vector<point_type> >(std::move(p.second));
 		}
 
-		const std::vector<point_type>& pts() const {
-			return pts_;
+		points_ptr_t pts(const std::string& attr) const {
+			auto itr = pts_.find(attr);
+			return itr == pts_.end() ? points_ptr_t() : itr->second;
 		}
 		
 		void set_send_disable() {
@@ -190,8 +212,9 @@ private:
 		void set_current_sub( iterator_type i ) { latest_subiter = i; }
 		void set_next_t( time_type t ) { next_timestamp = t; }
 		void set_next_sub( iterator_type i ) { next_subiter = i; }
+		codec::state& decoder() { return decoder_; }
 	private:
-		bool scan_spans_(time_type t, const span_t& s, const spans_type& spans ) const {
+		bool scan_spans_(time_type t, const span_t& s, const spans_type& spans) const {
 			bool prefetched = false;
 			auto end = spans.lower_bound(std::make_pair(t,t));
 			if( spans.size() == 1 ) end = spans.end();
@@ -214,29 +237,82 @@ private:
 		iterator_type next_subiter = std::numeric_limits<iterator_type>::lowest();
 		spans_type recving_spans;
 		spans_type sending_spans;
-		std::vector<point_type> pts_;
+		std::unordered_map<std::string, points_ptr_t> pts_;
 		std::unordered_map<std::string, storage_single_t> assigned_vals_;
+		codec::state decoder_; // reference frames of encoded data from this peer
 		bool disable_send;
 		bool disable_recv;
 		bool ss_stat_send;
 		bool ss_stat_recv;
 	};
 
+	/** \brief A commit taken off the push buffers, packed and sent possibly on another thread
+	*/
+	struct commit_job_ {
+		std::pair<time_type,iterator_type> time;
+		std::vector<bool> dest;
+		frame_type data;
+		frame_raw_type raw;
+		frame_pts_type pts;
+		std::size_t bytes = 0; // estimate of the memory held until sent
+		std::vector<message> msgs;
+		bool packed = false;
+		bool sent = false;
+	};
+
+	struct bytes_ {
+		template<typename T> std::size_t operator()( const std::vector<T>& t ) const { return t.size()*sizeof(T); }
+	};
+
+	/** \brief Frames of one attribute taken by a temporal sampler at one time and their weights
+	*/
+	struct window_ {
+		std::size_t version;
+		std::pair<time_type,iterator_type> focus;
+		const std::type_info* sampler;
+		std::shared_ptr<const void> state; // copy of the temporal sampler, compared through its operator==
+		std::vector<std::pair<spatial_t*, REAL> > frames;
+		REAL divisor;
+	};
+
+	static const std::size_t WINDOW_CACHE_SIZE = 4; // windows kept per attribute
+
 private: // data members
+	metrics metrics_; // declared first so that it outlives the communicator threads
 	std::unique_ptr<communicator> comm;
 	dispatcher<message::id_type, std::function<void(message)> > readers;
 
 	std::map<std::pair<time_type, iterator_type>, bin_frame_type> log;
+	std::size_t log_version_ = 0; // changes with every change to log or to the times peers reached, see window_for_()
+	// recently used windows of each attribute, most recent first, see window_for_()
+	std::unordered_map<std::string, std::list<std::shared_ptr<const window_> > > windows_;
+	std::mutex windows_mutex_;
+	// latest spatial index of each attribute, reused by frames with the same points
+	std::unordered_map<std::string, std::shared_ptr<index_cache_t> > index_cache_;
 
 	frame_type push_buffer;
 	frame_raw_type push_buffer_raw;
-	std::vector<point_type> push_buffer_pts;
+	frame_pts_type push_buffer_pts;
 
 	std::unordered_map<std::string, storage_single_t > assigned_values;
 
+	std::unordered_map<std::string, codec_config> codecs_;
+	std::unique_ptr<codec_config> default_codec_;
+	codec::state codec_;
+	std::vector<bool> codec_peers_; // destinations of the last encoded frame
+
 	std::vector<peer_state> peers;
 	std::vector<bool> peer_is_sending;
 	bool smart_send_set_ = true;
+	// receiving spans of the peers grouped by the time window they cover, see update_smart_send()
+	struct recv_window_ {
+		geometry::bvh<CONFIG> index;                                // bounding boxes of spans
+		std::vector<std::pair<std::size_t, const span_t*> > spans; // peer and span of each box
+	};
+	std::map<std::pair<time_type,time_type>, recv_window_> recv_windows_;
+	std::vector<const recv_window_*> recv_active_; // windows in force at the last update
+	std::vector<bool> recv_default_;               // per peer: sending unless a span in force rules it out
+	bool recv_index_dirty_ = true;
 	time_type span_start = std::numeric_limits<time_type>::lowest();
 	time_type span_timeout = std::numeric_limits<time_type>::lowest();
 	span_t current_span;
@@ -246,29 +322,76 @@ private: // data members
 	time_type memory_length = std::numeric_limits<time_type>::max();
 	std::mutex mutex;
 	bool initialized_pts_;
-	size_t fixedPointCount_;
 	time_type fetch_t_hist_ = std::numeric_limits<time_type>::lowest();
 	iterator_type fetch_i_hist_ = std::numeric_limits<iterator_type>::lowest();
 
+	// peers the barrier in progress still waits for, kept up to date by the handlers, see barrier_wait_()
+	bool barrier_active_ = false;
+	bool barrier_by_it_ = false;
+	time_type barrier_t_ = time_type();
+	iterator_type barrier_it_ = iterator_type();
+	std::vector<bool> barrier_blocked_;
+	std::size_t barrier_outstanding_ = 0;
+
+	// background commit pipeline, see async_commit()
+	std::thread async_worker_;
+	std::mutex async_mutex_;
+	std::condition_variable async_cv_;
+	std::deque<std::shared_ptr<commit_job_> > async_jobs_; // not yet sent, in commit order
+	std::deque<std::shared_ptr<commit_job_> > async_pack_; // not yet packed, in commit order
+	std::size_t async_bytes_ = 0;
+	std::size_t async_limit_ = std::size_t(256) << 20;
+	bool async_concurrent_ = false;
+	bool async_stop_ = false;
+	std::exception_ptr async_error_;
+
 public:
+	/** \brief Handle to a commit started with async_commit()
+	*/
+	class commit_handle {
+	public:
+		commit_handle() : owner_(nullptr) {}
+
+		/** \brief Tests without blocking whether the commit has been sent
+		*/
+		bool ready() {
+			if( !job_ ) return true;
+			owner_->flush_commits_( false );
+			std::lock_guard<std::mutex> lock(owner_->async_mutex_);
+			return job_->sent;
+		}
+
+		/** \brief Blocks until the commit has been sent, returns the number of peers contacted
+		*/
+		int wait() {
+			if( !job_ ) return 0;
+			owner_->flush_commits_( true, job_.get() );
+			return std::count( job_->dest.begin(), job_->dest.end(), true );
+		}
+	private:
+		friend class uniface;
+		commit_handle( uniface* owner, std::shared_ptr<commit_job_> job ) : owner_(owner), job_(std::move(job)) {}
+
+		uniface* owner_;
+		std::shared_ptr<commit_job_> job_;
+	};
+
 	uniface( const char URI[] ) : uniface( comm_factory::create_comm(URI, QUIET) ) {}
 	uniface( std::string const &URI ) : uniface( comm_factory::create_comm(URI.c_str(), QUIET) ) {}
-	uniface( communicator* comm_ ) : comm(comm_), initialized_pts_(false), fixedPointCount_(0) {
+	uniface( communicator* comm_ ) : comm(comm_), initialized_pts_(false) {
 		using namespace std::placeholders;
 
+		metrics_.set_pid(comm->local_rank());
+		comm->set_metrics(&metrics_);
+
 		peers.resize(comm->remote_size());
 		peer_is_sending.resize(comm->remote_size(), true);
 
-		readers.link("timestamp", reader_variables<int32_t, std::pair<time_type,iterator_type> >(
-					 std::bind(&uniface::on_recv_confirm, this, std::placeholders:: _1, std::placeholders:: _2)));
+		readers.link("commit", reader_variables<int32_t, std::pair<time_type,iterator_type>, frame_pts_type, frame_raw_type, frame_transfer_type, frame_codec_type, frame_codec_type>(
+					 std::bind(&uniface::on_recv_commit, this, std::placeholders::_1, std::placeholders::_2, std::placeholders::_3,
+					           std::placeholders::_4, std::placeholders::_5, std::placeholders::_6, std::placeholders::_7)));
 		readers.link("forecast", reader_variables<int32_t, std::pair<time_type,iterator_type>>(
 					 std::bind(&uniface::on_recv_forecast, this, std::placeholders:: _1, std::placeholders:: _2)));
-		readers.link("data", reader_variables<std::pair<time_type,iterator_type>, frame_type>(
-					 std::bind(&uniface::on_recv_data, this, std::placeholders:: _1, std::placeholders:: _2)));
-		readers.link("rawdata", reader_variables<int32_t, std::pair<time_type,iterator_type>, frame_raw_type>(
-					 std::bind(&uniface::on_recv_rawdata, this, std::placeholders::_1, std::placeholders::_2,std::placeholders:: _3)));
-		readers.link("points", reader_variables<int32_t, std::vector<point_type>>(
-					 std::bind(&uniface::on_recv_points, this,std::placeholders:: _1, std::placeholders:: _2)));
 		readers.link("assignedVals", reader_variables<std::string, storage_single_t>(
 					 std::bind(&uniface::on_recv_assignedVals, this,std::placeholders:: _1,std::placeholders:: _2)));
 		readers.link("receivingSpan", reader_variables<int32_t, time_type,time_type, span_t>(
@@ -284,31 +407,44 @@ public:
 	uniface( const uniface& ) = delete;
 	uniface& operator=( const uniface& ) = delete;
 
+	~uniface() {
+		try {
+			drain_commits_();
+		}
+		catch( std::exception& e ) {
+			std::cerr << "MUI Error [uniface.h]: Asynchronous commit failed: " << e.what() << std::endl;
+		}
+		{
+			std::lock_guard<std::mutex> lock(async_mutex_);
+			async_stop_ = true;
+		}
+		async_cv_.notify_all();
+		if( async_worker_.joinable() ) async_worker_.join();
+	}
+
 	/** \brief Announce the value \c value with the parameter \c attr
 	* Useful if, for example, you wish to pass a parameter
 	* rather than a field without an associated timestamp
 	*/
 	template<typename TYPE>
 	void push( const std::string& attr, const TYPE& value ) {
+		drain_commits_();
 		comm->send(message::make("assignedVals", attr, storage_single_t(TYPE(value))));
 	}
 
 	/** \brief Push data with tag "attr" to buffer
 	* Push data with tag "attr" to bcuffer. If using CONFIG::FIXEDPOINTS=true,
-	* data must be pushed in the same order that the points were previously pushed.
+	* data must be pushed in the same order that the points of "attr" were previously pushed.
    	*/
 	template<typename TYPE>
 	void push( const std::string& attr, const point_type& loc, const TYPE& value ) {
 		if( FIXEDPOINTS ) {
 			// If this push is before first commit then build local points list
-			if( !initialized_pts_ ) push_buffer_pts.emplace_back( loc );
+			if( !initialized_pts_ ) push_buffer_pts[attr].emplace_back( loc );
 
 			storage_raw_t& n = push_buffer_raw[attr];
-			if( !n ) n = storage_raw_t(std::vector<std::pair<size_t,TYPE> >());
-			storage_cast<std::vector<std::pair<size_t,TYPE> >&>(n).emplace_back( fixedPointCount_, value );
-
-			// Increment counter for flat fixed point list
-			fixedPointCount_++;
+			if( !n ) n = storage_raw_t(std::vector<TYPE>());
+			storage_cast<std::vector<TYPE>&>(n).emplace_back( value );
 		} 
 		else {
 			storage_t& n = push_buffer[attr];
@@ -450,38 +586,14 @@ public:
 	fetch( const std::string& attr,const point_type& focus, const time_type t,
 		   SAMPLER& sampler, const TIME_SAMPLER &t_sampler, bool barrier_enabled = true,
 		   ADDITIONAL && ... additional ) {
-		// Only enter barrier on first fetch for time=t
+		// Only enter barrier on first fetch for the barrier time of t
 		
-		if( fetch_t_hist_ != t && barrier_enabled ){
-			auto t0 = std::chrono::system_clock::now();
+		if( fetch_t_hist_ != t_sampler.get_upper_bound(t) && barrier_enabled )
 			barrier(t_sampler.get_upper_bound(t));
-			auto t1 = std::chrono::system_clock::now();
-			std::chrono::duration<double> elapsed_seconds = t1-t0;
-
-			std::cout << " barrier time is "<<  elapsed_seconds.count() << " (s)" <<std::endl;
-
-		}
-
-		fetch_t_hist_ = t;
 
+		fetch_t_hist_ = t_sampler.get_upper_bound(t);
 
-		std::vector<std::pair<std::pair<time_type,iterator_type>,typename SAMPLER::OTYPE> > v;
-		std::pair<time_type,iterator_type> curr_time_lower(t_sampler.get_lower_bound(t)-threshold(t),
-			  	  	  	  	  	  	  	  	  	  	  	   std::numeric_limits<iterator_type>::lowest());
-
-		std::pair<time_type,iterator_type> curr_time_upper(t_sampler.get_upper_bound(t)+threshold(t),
-			  	  	  	  	  	  	  	  	  	  	  	   std::numeric_limits<iterator_type>::lowest());
-		auto end = log.upper_bound(curr_time_upper);
-
-		if( log.size() == 1 ) end = log.end();
-
-		for( auto start = log.lower_bound(curr_time_lower); start != end; ++start ) {
-			const auto& iter = start->second.find(attr);
-			if( iter == start->second.end() ) continue;
-			v.emplace_back( start->first, iter->second.build_and_query_ts( focus, sampler, additional... ) );
-		}
-
-		return t_sampler.filter(t, v);
+		return sample_window_( attr, focus, t, sampler, t_sampler, additional... );
 	}
 
 	/** \brief Fetch from the interface, blocking with barrier at time=t,it
@@ -491,30 +603,14 @@ public:
 	fetch( const std::string& attr,const point_type& focus, const time_type t, const iterator_type it,
 		   SAMPLER& sampler, const TIME_SAMPLER &t_sampler, bool barrier_enabled = true,
 		   ADDITIONAL && ... additional ) {
-		// Only enter barrier on first fetch for time=t,iteration=it
-		if((fetch_t_hist_ != t || fetch_i_hist_ != it) && barrier_enabled)
+		// Only enter barrier on first fetch for the barrier time of t,it
+		if((fetch_t_hist_ != t_sampler.get_upper_bound(t) || fetch_i_hist_ != t_sampler.get_upper_bound(it)) && barrier_enabled)
 			barrier(t_sampler.get_upper_bound(t),t_sampler.get_upper_bound(it));
 
-		fetch_t_hist_ = t;
-		fetch_i_hist_ = it;
-
-		std::vector<std::pair<std::pair<time_type,iterator_type>,typename SAMPLER::OTYPE> > v;
-		std::pair<time_type,iterator_type> curr_time_lower(t_sampler.get_lower_bound(t)-threshold(t),
-														   t_sampler.get_lower_bound(it)-threshold(it));
-
-		std::pair<time_type,iterator_type> curr_time_upper(t_sampler.get_upper_bound(t)+threshold(t),
-														   t_sampler.get_upper_bound(it)+threshold(it));
-		auto end = log.upper_bound(curr_time_upper);
-
-		if( log.size() == 1 ) end = log.end();
-
-		for( auto start = log.lower_bound(curr_time_lower); start != end; ++start ) {
-			const auto& iter = start->second.find(attr);
-			if( iter == start->second.end() ) continue;
-			v.emplace_back( start->first, iter->second.build_and_query_ts( focus, sampler, additional... ) );
-		}
+		fetch_t_hist_ = t_sampler.get_upper_bound(t);
+		fetch_i_hist_ = t_sampler.get_upper_bound(it);
 
-		return t_sampler.filter(std::make_pair(t,it), v);
+		return sample_window_( attr, focus, std::make_pair(t,it), sampler, t_sampler, additional... );
 	}
 
 	/** \brief Fetch from the interface with coupling algorithms, blocking with barrier at time=t
@@ -524,29 +620,14 @@ public:
 	fetch( const std::string& attr,const point_type& focus, const time_type t,
 		   SAMPLER& sampler, const TIME_SAMPLER &t_sampler, const COUPLING_ALGO &cpl_algo, 
 		   bool barrier_enabled = true, ADDITIONAL && ... additional ) {
-		// Only enter barrier on first fetch for time=t
-		if( fetch_t_hist_ != t && barrier_enabled )
+		// Only enter barrier on first fetch for the barrier time of t
+		if( fetch_t_hist_ != t_sampler.get_upper_bound(t) && barrier_enabled )
 			barrier(t_sampler.get_upper_bound(t));
 
-		fetch_t_hist_ = t;
-
-		std::vector<std::pair<std::pair<time_type,iterator_type>,typename SAMPLER::OTYPE> > v;
-		std::pair<time_type,iterator_type> curr_time_lower(t_sampler.get_lower_bound(t)-threshold(t),
-														std::numeric_limits<iterator_type>::lowest());
-
-		std::pair<time_type,iterator_type> curr_time_upper(t_sampler.get_upper_bound(t)+threshold(t),
-														std::numeric_limits<iterator_type>::lowest());
-		auto end = log.upper_bound(curr_time_upper);
+		fetch_t_hist_ = t_sampler.get_upper_bound(t);
 
-		if( log.size() == 1 ) end = log.end();
-
-		for( auto start = log.lower_bound(curr_time_lower); start != end; ++start ) {
-			const auto& iter = start->second.find(attr);
-			if( iter == start->second.end() ) continue;
-			v.emplace_back( start->first, iter->second.build_and_query_ts( focus, sampler, additional... ) );
-		}
-
-		return cpl_algo.relaxation(std::make_pair(std::numeric_limits<time_type>::lowest(), static_cast<iterator_type>(t)), focus, t_sampler.filter(t, v));
+		return cpl_algo.relaxation(std::make_pair(std::numeric_limits<time_type>::lowest(), static_cast<iterator_type>(t)), focus,
+		                           sample_window_( attr, focus, t, sampler, t_sampler, additional... ));
 	}
 
 	/** \brief Fetch from the interface with coupling algorithms, blocking with barrier at time=t,it
@@ -556,30 +637,15 @@ public:
 	fetch( const std::string& attr,const point_type& focus, const time_type t, const iterator_type it,
 		   SAMPLER& sampler, const TIME_SAMPLER &t_sampler, const COUPLING_ALGO &cpl_algo, 
 		   bool barrier_enabled = true, ADDITIONAL && ... additional ) {
-		// Only enter barrier on first fetch for time=t,iteration=it
-		if((fetch_t_hist_ != t || fetch_i_hist_ != it) && barrier_enabled)
+		// Only enter barrier on first fetch for the barrier time of t,it
+		if((fetch_t_hist_ != t_sampler.get_upper_bound(t) || fetch_i_hist_ != t_sampler.get_upper_bound(it)) && barrier_enabled)
 			barrier(t_sampler.get_upper_bound(t),t_sampler.get_upper_bound(it));
 
-		fetch_t_hist_ = t;
-		fetch_i_hist_ = it;
+		fetch_t_hist_ = t_sampler.get_upper_bound(t);
+		fetch_i_hist_ = t_sampler.get_upper_bound(it);
 
-		std::vector<std::pair<std::pair<time_type,iterator_type>,typename SAMPLER::OTYPE> > v;
-		std::pair<time_type,iterator_type> curr_time_lower(t_sampler.get_lower_bound(t)-threshold(t),
-														   t_sampler.get_lower_bound(it)-threshold(it));
-
-		std::pair<time_type,iterator_type> curr_time_upper(t_sampler.get_upper_bound(t)+threshold(t),
-														   t_sampler.get_upper_bound(it)+threshold(it));
-		auto end = log.upper_bound(curr_time_upper);
-
-		if( log.size() == 1 ) end = log.end();
-
-		for( auto start = log.lower_bound(curr_time_lower); start != end; ++start ) {
-			const auto& iter = start->second.find(attr);
-			if( iter == start->second.end() ) continue;
-			v.emplace_back( start->first, iter->second.build_and_query_ts( focus, sampler, additional... ) );
-		}
-
-		return cpl_algo.relaxation(std::make_pair(t,it), focus, t_sampler.filter(std::make_pair(t,it), v));
+		return cpl_algo.relaxation(std::make_pair(t,it), focus,
+		                           sample_window_( attr, focus, std::make_pair(t,it), sampler, t_sampler, additional... ));
 	}
 
 	/** \brief Fetch points currently stored in the interface, blocking with barrier at time=t
@@ -588,13 +654,12 @@ public:
 	std::vector<point_type>
 	fetch_points( const std::string& attr, const time_type t,
 				  const TIME_SAMPLER &t_sampler, bool barrier_enabled = true, ADDITIONAL && ... additional ) {
-		// Only enter barrier on first fetch for time=t
-		if( fetch_t_hist_ != t && barrier_enabled )
+		// Only enter barrier on first fetch for the barrier time of t
+		if( fetch_t_hist_ != t_sampler.get_upper_bound(t) && barrier_enabled )
 			barrier(t_sampler.get_upper_bound(t));
 
-		fetch_t_hist_ = t;
+		fetch_t_hist_ = t_sampler.get_upper_bound(t);
 
-		using vec = std::vector<std::pair<point_type,TYPE> >;
 		std::vector <point_type> return_points;
 
 		std::pair<time_type,iterator_type> curr_time_lower(t_sampler.get_lower_bound(t)-threshold(t),
@@ -609,11 +674,9 @@ public:
 		for( auto start = log.lower_bound(curr_time_lower); start != end; ++start ){
 			const auto& iter = start->second.find(attr);
 			if( iter == start->second.end() ) continue;
-			const vec& ds = iter->second.template return_data<TYPE>();
-			return_points.reserve(ds.size());
-			for( size_t i=0; i<ds.size(); i++ ) {
-				return_points.emplace_back(ds[i].first);
-			}
+			build_(iter->second);
+			const std::vector<point_type>& ds = iter->second.points();
+			return_points.insert(return_points.end(), ds.begin(), ds.end());
 		}
 
 		return return_points;
@@ -625,14 +688,13 @@ public:
 	std::vector<point_type>
 	fetch_points( const std::string& attr, const time_type t, const iterator_type it,
 				  const TIME_SAMPLER &t_sampler, bool barrier_enabled = true, ADDITIONAL && ... additional ) {
-		// Only enter barrier on first fetch for time=t,iteration=it
-		if( fetch_t_hist_ != t && fetch_i_hist_ != it && barrier_enabled)
+		// Only enter barrier on first fetch for the barrier time of t,it
+		if( fetch_t_hist_ != t_sampler.get_upper_bound(t) && fetch_i_hist_ != t_sampler.get_upper_bound(it) && barrier_enabled)
 			barrier(t_sampler.get_upper_bound(t),t_sampler.get_upper_bound(it));
 
-		fetch_t_hist_ = t;
-		fetch_i_hist_ = it;
+		fetch_t_hist_ = t_sampler.get_upper_bound(t);
+		fetch_i_hist_ = t_sampler.get_upper_bound(it);
 
-		using vec = std::vector<std::pair<point_type,TYPE> >;
 		std::vector <point_type> return_points;
 
 		std::pair<time_type,iterator_type> curr_time_lower(t_sampler.get_lower_bound(t)-threshold(t),
@@ -648,11 +710,9 @@ public:
 		for( auto start = log.lower_bound(curr_time_lower); start != end; ++start ){
 			const auto& iter = start->second.find(attr);
 			if( iter == start->second.end() ) continue;
-			const vec& ds = iter->second.template return_data<TYPE>();
-			return_points.reserve(ds.size());
-			for( size_t i=0; i<ds.size(); i++ ) {
-				return_points.emplace_back(ds[i].first);
-			}
+			build_(iter->second);
+			const std::vector<point_type>& ds = iter->second.points();
+			return_points.insert(return_points.end(), ds.begin(), ds.end());
 		}
 
 		return return_points;
@@ -664,13 +724,12 @@ public:
 	std::vector<TYPE>
 	fetch_values( const std::string& attr, const time_type t,
 				  const TIME_SAMPLER &t_sampler, bool barrier_enabled = true, ADDITIONAL && ... additional ) {
-		// Only enter barrier on first fetch for time=t,iteration=it
-		if( fetch_t_hist_ != t && barrier_enabled )
+		// Only enter barrier on first fetch for the barrier time of t,it
+		if( fetch_t_hist_ != t_sampler.get_upper_bound(t) && barrier_enabled )
 			barrier(t_sampler.get_upper_bound(t));
 
-		fetch_t_hist_ = t;
+		fetch_t_hist_ = t_sampler.get_upper_bound(t);
 
-		using vec = std::vector<std::pair<point_type,TYPE> >;
 		std::vector<TYPE> return_values;
 
 		std::pair<time_type,iterator_type> curr_time_lower(t_sampler.get_lower_bound(t)-threshold(t),
@@ -685,11 +744,9 @@ public:
 		for( auto start = log.lower_bound(curr_time_lower); start != end; ++start ){
 			const auto& iter = start->second.find(attr);
 			if( iter == start->second.end() ) continue;
-			const vec& ds = iter->second.template return_data<TYPE>();
-			return_values.reserve(ds.size());
-			for( size_t i=0; i<ds.size(); i++ ) {
-				return_values.emplace_back(ds[i].second);
-			}
+			build_(iter->second);
+			const std::vector<TYPE> ds = iter->second.template ordered_values<TYPE>();
+			return_values.insert(return_values.end(), ds.begin(), ds.end());
 		}
 
 		return return_values;
@@ -701,14 +758,13 @@ public:
 	std::vector<TYPE>
 	fetch_values( const std::string& attr, const time_type t, const iterator_type it,
 				  const TIME_SAMPLER &t_sampler, bool barrier_enabled = true, ADDITIONAL && ... additional ) {
-		// Only enter barrier on first fetch for time=t,iteration=it
-		if( fetch_t_hist_ != t && fetch_i_hist_ != it && barrier_enabled)
+		// Only enter barrier on first fetch for the barrier time of t,it
+		if( fetch_t_hist_ != t_sampler.get_upper_bound(t) && fetch_i_hist_ != t_sampler.get_upper_bound(it) && barrier_enabled)
 			barrier(t_sampler.get_upper_bound(t),t_sampler.get_upper_bound(it));
 
-		fetch_t_hist_ = t;
-		fetch_i_hist_ = it;
+		fetch_t_hist_ = t_sampler.get_upper_bound(t);
+		fetch_i_hist_ = t_sampler.get_upper_bound(it);
 
-		using vec = std::vector<std::pair<point_type,TYPE> >;
 		std::vector<TYPE> return_values;
 
 		std::pair<time_type,iterator_type> curr_time_lower(t_sampler.get_lower_bound(t)-threshold(t),
@@ -723,57 +779,90 @@ public:
 		for( auto start = log.lower_bound(curr_time_lower); start != end; ++start ){
 			const auto& iter = start->second.find(attr);
 			if( iter == start->second.end() ) continue;
-			const vec& ds = iter->second.template return_data<TYPE>();
-			return_values.reserve(ds.size());
-			for( size_t i=0; i<ds.size(); i++ ) {
-				return_values.emplace_back(ds[i].second);
-			}
+			build_(iter->second);
+			const std::vector<TYPE> ds = iter->second.template ordered_values<TYPE>();
+			return_values.insert(return_values.end(), ds.begin(), ds.end());
 		}
 
 		return return_values;
 	}
 
+	/** \brief Sets the codec used to send frames of attribute "attr"
+	* Receivers need no matching call, every encoded frame describes its own codec.
+	*/
+	void set_codec( const std::string& attr, const codec_config& config ) {
+		drain_commits_();
+		codecs_[attr] = config;
+	}
+
+	/** \brief Sets the codec used to send frames of attributes without their own codec
+	*/
+	void set_codec( const codec_config& config ) {
+		drain_commits_();
+		default_codec_.reset(new codec_config(config));
+	}
+
 	/** \brief Serializes pushed data and sends it to remote nodes
 	* Serializes pushed data and sends it to remote nodes.
 	* Returns the actual number of peers contacted
 	*/
 	int commit( time_type t, iterator_type it = std::numeric_limits<iterator_type>::lowest() ) {
-		std::pair<time_type, iterator_type> time(t, it);
+		// Earlier asynchronous commits go out first
+		drain_commits_();
 
-    	// Check Smart Send if announcement made
-    	if ( !smart_send_set_ ) {
-    		// Reset all peers to default of enabled
-    		std::fill(peer_is_sending.begin(), peer_is_sending.end(), true);
-    		update_smart_send(t);
-    		smart_send_set_ = true;
-    	}
+		commit_job_ job;
+		prepare_commit_( job, t, it );
+		pack_commit_( job );
+		send_commit_( job );
 
-		if( FIXEDPOINTS ) {
-			// This only happens during the first commit
-			if( push_buffer_pts.size() > 0 ) {
-				comm->send( message::make("points",comm->local_rank(),std::move(push_buffer_pts)),peer_is_sending );
-				initialized_pts_ = true;
-				push_buffer_pts.clear();
-			}
+		return std::count( job.dest.begin(),job.dest.end(),true );
+	}
 
-			// Reset counter for flat point structure
-			fixedPointCount_ = 0;
+	/** \brief Commits pushed data without waiting for it to be serialized and sent
+	* The push buffers are handed to a background thread and can be refilled at once.
+	* Frames are sent in commit order; any later call that talks to remote nodes
+	* (commit, barrier, fetch, forecast, announce_*) first waits for them to go out.
+	* When the communicator allows it the background thread sends as well, otherwise
+	* packed frames are sent by the calling thread on its next call into the interface.
+	* Blocks while more than set_async_limit() bytes of earlier commits are unsent.
+	*/
+	commit_handle async_commit( time_type t, iterator_type it = std::numeric_limits<iterator_type>::lowest() ) {
+		auto job = std::make_shared<commit_job_>();
+		prepare_commit_( *job, t, it );
 
-			if( push_buffer_raw.size() > 0 ) {
-				comm->send( message::make("rawdata",comm->local_rank(),time,std::move(push_buffer_raw)),peer_is_sending );
-				push_buffer_raw.clear();
+		// Bound the memory held by commits in flight, a single oversized commit still proceeds
+		for(;;) {
+			std::shared_ptr<commit_job_> oldest;
+			{
+				std::lock_guard<std::mutex> lock(async_mutex_);
+				if( async_jobs_.empty() || async_bytes_ + job->bytes <= async_limit_ ) break;
+				oldest = async_jobs_.front();
 			}
+			flush_commits_( true, oldest.get() );
 		}
-		else {
-			if( push_buffer.size() > 0 ) {
-				comm->send( message::make("data",time,std::move(push_buffer)),peer_is_sending );
-				push_buffer.clear();
+
+		{
+			std::lock_guard<std::mutex> lock(async_mutex_);
+			if( !async_worker_.joinable() ) {
+				async_concurrent_ = comm->concurrent_send();
+				async_worker_ = std::thread(&uniface::async_work_, this);
 			}
+			async_jobs_.push_back(job);
+			async_pack_.push_back(job);
+			async_bytes_ += job->bytes;
 		}
+		async_cv_.notify_all();
 
-		comm->send( message::make("timestamp",comm->local_rank(),time),peer_is_sending );
+		flush_commits_( false );
 
-		return std::count( peer_is_sending.begin(),peer_is_sending.end(),true );
+		return commit_handle(this, std::move(job));
+	}
+
+	/** \brief Sets the bound on the bytes held by unsent asynchronous commits
+	*/
+	void set_async_limit( std::size_t bytes ) {
+		std::lock_guard<std::mutex> lock(async_mutex_);
+		async_limit_ = bytes;
 	}
 
 	/** \brief Updates Smart Send locality data
@@ -782,15 +871,34 @@ public:
 	void update_smart_send( time_type t ) {
 		if( (((span_start < t) || almost_equal(span_start, t)) &&
 	        ((t < span_timeout) || almost_equal(t, span_timeout))) ) {
-			for( size_t i=0; i < peers.size(); i++ ) {
-				// Check if peer is explicitly disabled
-				if( peers[i].is_recv_disabled() ) {
-					peer_is_sending[i] = false;
-					continue;
-				}
+			// A peer is sent to if it has no receiving span in force at t, or one of those spans
+			// meets the current span (see peer_state::is_recving). Spans are indexed per time window,
+			// so only the peers whose boxes meet the current span are looked at individually.
+			const bool rebuilt = recv_index_dirty_;
+			if( recv_index_dirty_ ) build_recv_windows_();
+
+			std::vector<const recv_window_*> active;
+			for( const auto& w: recv_windows_ ) {
+				if( !(w.first < std::make_pair(t,t)) ) break;
+				if( t < w.first.second || almost_equal(t, w.first.second) ) active.push_back(&w.second);
+			}
+			if( rebuilt || active != recv_active_ ) {
+				recv_active_.swap(active);
+				recv_default_.assign(peers.size(), true);
+				for( const recv_window_* w: recv_active_ )
+					for( const auto& s: w->spans ) recv_default_[s.first] = false;
+				for( size_t i=0; i < peers.size(); i++ )
+					if( peers[i].is_recv_disabled() ) recv_default_[i] = false;
+			}
 
-				// Perform geometric check against defined regions
-				peer_is_sending[i] = peers[i].is_recving( t, current_span );
+			peer_is_sending = recv_default_;
+			const geometry::box<CONFIG> bx = current_span.bbox();
+			for( const recv_window_* w: recv_active_ ) {
+				w->index.query(bx, [&](std::size_t k) {
+					const std::size_t i = w->spans[k].first;
+					if( !peer_is_sending[i] && !peers[i].is_recv_disabled() && collide(current_span, *w->spans[k].second) )
+						peer_is_sending[i] = true;
+				});
 			}
 	  }
 	  else { // Ensure explicitly disabled peers are taken into account if outside Smart Send time bounds
@@ -800,12 +908,35 @@ public:
 	  }
 	}
 
+	/** \brief Groups the receiving spans of the peers by time window and indexes each group
+	*/
+	void build_recv_windows_() {
+		recv_windows_.clear();
+		for( size_t i=0; i < peers.size(); i++ ) {
+			const auto& spans = peers[i].recving_spans_all();
+			for( const auto& s: spans ) {
+				// a peer's only span is in force from the start, as in peer_state::is_recving
+				const time_type start = spans.size() == 1 ? std::numeric_limits<time_type>::lowest() : s.first.first;
+				recv_windows_[std::make_pair(start, s.first.second)].spans.emplace_back(i, &s.second);
+			}
+		}
+		for( auto& w: recv_windows_ ) {
+			std::vector<std::pair<geometry::box<CONFIG>, std::size_t> > boxes;
+			boxes.reserve(w.second.spans.size());
+			for( std::size_t k=0; k < w.second.spans.size(); k++ ) boxes.emplace_back(w.second.spans[k].second->bbox(), k);
+			w.second.index.build(std::move(boxes));
+		}
+		recv_active_.clear();
+		recv_index_dirty_ = false;
+	}
+
 	int get_sendig_peers_size(){
 		return std::count( peer_is_sending.begin(),peer_is_sending.end(),true );
 	}
 	/** \brief Sends a forecast of an upcoming time to remote nodes
 	*/
 	void forecast( time_type t, iterator_type it = std::numeric_limits<iterator_type>::lowest()) {
+		drain_commits_();
 		std::pair<time_type,iterator_type> time(t,it);
 		comm->send(message::make("forecast", comm->local_rank(), time));
 	}
@@ -836,27 +967,15 @@ public:
 	/** \brief Blocking barrier at time=t. Initiates receive from remote nodes.
 	*/
 	void barrier( time_type t ) {
+		drain_commits_();
+
 		// barrier must be thread-safe because it is called in fetch()
 		std::lock_guard<std::mutex> lock(mutex);
+		metrics::timer timer(&metrics_, metrics::BARRIER);
 
 		auto start = std::chrono::system_clock::now();
 
-		for(;;) {
-			size_t peers_unblocked = 0;
-			for( size_t p = 0; p < peers.size(); p++ ) {
-				if( peers[p].is_send_disabled() ) { peers_unblocked++; continue; } // Rank disabled, immediate break
-				if( !peers[p].is_sending(t, recv_span) ) { peers_unblocked++; continue; } // Rank disabled due to Smart Send geometry check
-				if( (peers[p].current_t() > t || almost_equal(peers[p].current_t(), t)) || peers[p].next_t() > t ) { // Final time check
-					peers_unblocked++;
-					continue;
-				}
-			}
-			// All peers unblocked, break loop
-			if( peers_unblocked == peers.size() )
-				break;
-			else // Acquire messages
-				acquire();
-		}
+		barrier_wait_(t, iterator_type(), false);
 
 		if( !QUIET ) {
 			if( (std::chrono::system_clock::now() - start) > std::chrono::seconds(5) ) {
@@ -868,28 +987,15 @@ public:
 	/** \brief Blocking barrier at time=t,it. Initiates receive from remote nodes.
 	*/
 	void barrier( time_type t, iterator_type it ) {
+		drain_commits_();
+
 		// barrier must be thread-safe because it is called in fetch()
 		std::lock_guard<std::mutex> lock(mutex);
+		metrics::timer timer(&metrics_, metrics::BARRIER);
 
 		auto start = std::chrono::system_clock::now();
 
-		for(;;) {
-			size_t peers_unblocked = 0;
-			for( size_t p = 0; p < peers.size(); p++ ) {
-				if( peers[p].is_send_disabled() ) { peers_unblocked++; continue; } // Rank disabled, immediate break
-				if( !peers[p].is_sending(t, recv_span) ) { peers_unblocked++; continue; } // Rank disabled due to Smart Send geometry check
-				if( ((peers[p].current_t() > t || almost_equal(peers[p].current_t(), t)) || peers[p].next_t() > t) && // Final time check
-					((peers[p].current_it() > it || almost_equal(peers[p].current_it(), it)) || peers[p].next_it() > it) ) {
-					peers_unblocked++;
-					continue;
-				}
-			}
-			// All peers unblocked, break loop
-			if( peers_unblocked == peers.size() )
-				break;
-			else // Acquire messages
-				acquire();
-		}
+		barrier_wait_(t, it, true);
 
 		if( !QUIET ) {
 			if( (std::chrono::system_clock::now() - start) > std::chrono::seconds(5) ) {
@@ -901,8 +1007,11 @@ public:
 	/** \brief Blocking barrier for Smart Send send values. Initiates receive from remote nodes.
     */
 	void barrier_ss_send( ) {
+		drain_commits_();
+
 		// barrier must be thread-safe because it is called in fetch()
 		std::lock_guard<std::mutex> lock(mutex);
+		metrics::timer timer(&metrics_, metrics::BARRIER_SS);
 
 		auto start = std::chrono::system_clock::now();
 
@@ -926,8 +1035,11 @@ public:
 	/** \brief Blocking barrier for Smart Send receive values. Initiates receive from remote nodes.
     */
 	void barrier_ss_recv( ) {
+		drain_commits_();
+
 		// barrier must be thread-safe because it is called in fetch()
 		std::lock_guard<std::mutex> lock(mutex);
+		metrics::timer timer(&metrics_, metrics::BARRIER_SS);
 
 		auto start = std::chrono::system_clock::now();
 
@@ -950,6 +1062,7 @@ public:
 	/** \brief Announces to all remote nodes using non-blocking peer-to-peer approach "I'll send this span"
 	*/
 	void announce_send_span( time_type start, time_type timeout, span_t s, bool synchronised = false) {
+		drain_commits_();
 		span_start = start;
 		span_timeout = timeout;
 		current_span.swap(s);
@@ -961,6 +1074,7 @@ public:
 	/** \brief Announces to all remote nodes "I'm disabled for send"
 	*/
 	void announce_send_disable( bool synchronised = false ) {
+		drain_commits_();
 		comm->send(message::make("sendingDisable", comm->local_rank()));
 		if( synchronised ) barrier_ss_send();
 	}
@@ -968,6 +1082,7 @@ public:
 	/** \brief Announces to all remote nodes using non-blocking peer-to-peer approach "I'm receiving this span"
 	*/
 	void announce_recv_span( time_type start, time_type timeout, span_t s, bool synchronised = false ) {
+		drain_commits_();
 		recv_start = start;
 		recv_timeout = timeout;
 		recv_span.swap(s);
@@ -979,10 +1094,40 @@ public:
 	/** \brief Announces to all remote nodes "I'm disabled for receive"
 	*/
 	void announce_recv_disable( bool synchronised = false ) {
+		drain_commits_();
 		comm->send(message::make("receivingDisable", comm->local_rank()));
 		if( synchronised ) barrier_ss_recv();
 	}
 
+	/** \brief Announces send and receive spans to all remote nodes in one collective step
+	* Every rank of both domains must call it. A rank that commits nothing passes
+	* send_enabled = false so that peers do not wait for it, and one that fetches nothing
+	* passes recv_enabled = false so that peers do not send to it. Where the communicator
+	* is collective (mpi://) each of the two rounds is a single MPI_Allgatherv over the
+	* intercommunicator, otherwise one message per pair of ranks and a Smart Send barrier.
+	*/
+	void announce_spans( time_type start, time_type timeout, span_t send_s, span_t recv_s,
+	                     bool send_enabled = true, bool recv_enabled = true ) {
+		drain_commits_();
+		if( send_enabled ) {
+			span_start = start;
+			span_timeout = timeout;
+			current_span.swap(send_s);
+			smart_send_set_ = false;
+			exchange_ss_( message::make("sendingSpan", comm->local_rank(), start, timeout, current_span), true );
+		}
+		else exchange_ss_( message::make("receivingDisable", comm->local_rank()), true );
+
+		if( recv_enabled ) {
+			recv_start = start;
+			recv_timeout = timeout;
+			recv_span.swap(recv_s);
+			smart_send_set_ = false;
+			exchange_ss_( message::make("receivingSpan", comm->local_rank(), start, timeout, recv_span), false );
+		}
+		else exchange_ss_( message::make("sendingDisable", comm->local_rank()), false );
+	}
+
 	/** \brief Removes log between (-inf, @last]
 	*/
 	void forget( time_type last, bool reset_log = false ) {
@@ -990,6 +1135,7 @@ public:
 													   std::numeric_limits<iterator_type>::lowest());
 
 		log.erase(log.begin(), log.upper_bound(upper_limit));
+		log_version_++;
 
 		if( reset_log ) {
 			std::pair<time_type,iterator_type> curr_time(std::numeric_limits<time_type>::lowest(),
@@ -1013,6 +1159,7 @@ public:
 												   last.second+threshold(last.second));
 
 		log.erase(log.begin(), log.upper_bound(upper_limit));
+		log_version_++;
 
 		if( reset_log ) {
 			std::pair<time_type,iterator_type> curr_time(std::numeric_limits<time_type>::lowest(),
@@ -1039,6 +1186,7 @@ public:
 				         	 	 	 	 	 	 	   std::numeric_limits<iterator_type>::lowest());
 
 		log.erase(log.lower_bound(lower_limit), log.upper_bound(upper_limit));
+		log_version_++;
 
 		if( reset_log ) {
 			std::pair<time_type,iterator_type> curr_time(std::numeric_limits<time_type>::lowest(),
@@ -1064,6 +1212,7 @@ public:
 													   last.second+threshold(last.second));
 
 		log.erase(log.lower_bound(lower_limit), log.upper_bound(upper_limit));
+		log_version_++;
 
 		if( reset_log ) {
 			std::pair<time_type,iterator_type> curr_time(std::numeric_limits<time_type>::lowest(),
@@ -1108,19 +1257,359 @@ public:
 		return comm->uri_protocol();
 	}
 
+	/** \brief Returns the counters and timers of this uniface, recorded when MUI_METRICS is defined
+	*/
+	metrics& get_metrics() {
+		return metrics_;
+	}
+
 private:
 	/** \brief Triggers communication
 	*/
 	void acquire() {
 		message m = comm->recv();
-		if( m.has_id() ) readers[m.id()](m);
+		metrics::timer timer(&metrics_, metrics::DESERIALISE);
+		if( m.has_id() ) readers[m.id()](std::move(m));
+	}
+
+	/** \brief Whether peer p still holds up a barrier at barrier_t_ (and barrier_it_)
+	*/
+	bool barrier_blocks_( const peer_state& p ) const {
+		if( p.is_send_disabled() ) return false; // Rank disabled, immediate break
+		if( !p.is_sending(barrier_t_, recv_span) ) return false; // Rank disabled due to Smart Send geometry check
+		// Final time check
+		if( (p.current_t() > barrier_t_ || almost_equal(p.current_t(), barrier_t_)) || p.next_t() > barrier_t_ ) {
+			if( !barrier_by_it_ ) return false;
+			if( (p.current_it() > barrier_it_ || almost_equal(p.current_it(), barrier_it_)) || p.next_it() > barrier_it_ ) return false;
+		}
+		return true;
+	}
+
+	/** \brief Re-checks the one peer whose state a handler has just changed
+	*/
+	void barrier_update_( int32_t sender ) {
+		if( !barrier_active_ ) return;
+		const bool blocked = barrier_blocks_(peers[sender]);
+		if( blocked == barrier_blocked_[sender] ) return;
+		barrier_blocked_[sender] = blocked;
+		if( blocked ) barrier_outstanding_++;
+		else barrier_outstanding_--;
+	}
+
+	/** \brief Receives until no peer holds up the barrier, mutex must be held
+	* Peers are checked once on entry; afterwards the handlers of the messages that move a
+	* peer on update the count of outstanding peers, so no pass over every peer is repeated.
+	* Each wakeup dispatches every message already waiting, not just the one it woke for.
+	*/
+	void barrier_wait_( time_type t, iterator_type it, bool by_it ) {
+		barrier_t_ = t;
+		barrier_it_ = it;
+		barrier_by_it_ = by_it;
+		barrier_blocked_.assign(peers.size(), false);
+		barrier_outstanding_ = 0;
+		for( size_t p = 0; p < peers.size(); p++ ) {
+			if( barrier_blocks_(peers[p]) ) {
+				barrier_blocked_[p] = true;
+				barrier_outstanding_++;
+			}
+		}
+
+		struct guard_ {
+			bool& active;
+			~guard_() { active = false; }
+		} guard{barrier_active_};
+		barrier_active_ = true;
+
+		while( barrier_outstanding_ > 0 ) {
+			acquire();
+			while( comm->ready() ) acquire();
+		}
 	}
 
-	/** \brief Handles "timestamp" messages
+	/** \brief Builds the bins of a frame if needed and samples it at focus
+	*/
+	template<class STORAGE, class SAMPLER, typename ... ADDITIONAL>
+	typename SAMPLER::OTYPE
+	sample_( STORAGE& storage, const point_type& focus, SAMPLER& sampler, ADDITIONAL && ... additional ) {
+		build_(storage);
+		metrics::timer timer(&metrics_, metrics::SAMPLER);
+		return storage.build_and_query_ts( focus, sampler, additional... );
+	}
+
+	/** \brief Builds the bins of a frame unless already built, so only actual builds are timed
+	*/
+	template<class STORAGE>
+	void build_( STORAGE& storage ) {
+		if( storage.is_built() ) return;
+		metrics::timer timer(&metrics_, metrics::BIN_BUILD);
+		storage.build_ts();
+	}
+
+	/** \brief Latest frame time t_sampler looks at around t: get_frame_upper_bound() for samplers
+	* that use frames the barrier does not wait for (interpolation past t), else get_upper_bound()
+	*/
+	template<class TIME_SAMPLER>
+	static auto frame_upper_bound_( const TIME_SAMPLER& t_sampler, time_type t, int ) -> decltype(t_sampler.get_frame_upper_bound(t)) {
+		return t_sampler.get_frame_upper_bound(t);
+	}
+
+	template<class TIME_SAMPLER>
+	static time_type frame_upper_bound_( const TIME_SAMPLER& t_sampler, time_type t, long ) {
+		return t_sampler.get_upper_bound(t);
+	}
+
+	/** \brief Latest committed frame a PREDICTS sampler may use, else no limit
+	*/
+	template<class TIME_SAMPLER>
+	auto committed_bound_( const TIME_SAMPLER&, time_type t, int ) const
+	-> typename std::enable_if<TIME_SAMPLER::PREDICTS, time_type>::type {
+		return committed_t_(t);
+	}
+
+	template<class TIME_SAMPLER>
+	time_type committed_bound_( const TIME_SAMPLER&, time_type, long ) const {
+		return std::numeric_limits<time_type>::max();
+	}
+
+	/** \brief Latest time every peer sending to this rank at t has committed. A peer that
+	* forecast a time past t sends nothing more before it and does not hold this back.
+	*/
+	time_type committed_t_( time_type t ) const {
+		time_type committed = std::numeric_limits<time_type>::max();
+		for( const peer_state& p: peers ) {
+			if( p.is_send_disabled() || !p.is_sending(t, recv_span) || p.next_t() > t ) continue;
+			committed = std::min(committed, p.current_t());
+		}
+		return committed;
+	}
+
+	/** \brief Bounds of the log entries t_sampler looks at around t
+	*/
+	template<class TIME_SAMPLER>
+	std::pair<std::pair<time_type,iterator_type>,std::pair<time_type,iterator_type> >
+	window_bounds_( const TIME_SAMPLER& t_sampler, time_type t ) {
+		return std::make_pair(std::make_pair(t_sampler.get_lower_bound(t)-threshold(t), std::numeric_limits<iterator_type>::lowest()),
+		                      std::make_pair(std::min(frame_upper_bound_(t_sampler, t, 0), committed_bound_(t_sampler, t, 0))+threshold(t),
+		                                     std::numeric_limits<iterator_type>::lowest()));
+	}
+
+	template<class TIME_SAMPLER>
+	std::pair<std::pair<time_type,iterator_type>,std::pair<time_type,iterator_type> >
+	window_bounds_( const TIME_SAMPLER& t_sampler, std::pair<time_type,iterator_type> t ) {
+		return std::make_pair(std::make_pair(t_sampler.get_lower_bound(t.first)-threshold(t.first), t_sampler.get_lower_bound(t.second)-threshold(t.second)),
+		                      std::make_pair(std::min(frame_upper_bound_(t_sampler, t.first, 0), committed_bound_(t_sampler, t.first, 0))+threshold(t.first),
+		                                     t_sampler.get_upper_bound(t.second)+threshold(t.second)));
+	}
+
+	static std::pair<time_type,iterator_type> window_key_( time_type t ) {
+		return std::make_pair(t, std::numeric_limits<iterator_type>::lowest());
+	}
+	static std::pair<time_type,iterator_type> window_key_( std::pair<time_type,iterator_type> t ) {
+		return t;
+	}
+
+	/** \brief True if the frames of TIME_SAMPLER can be combined through cached weights:
+	* it has weights() and operator==, and OTYPE is a floating point type.
+	* weights(focus, times, w) fills w so that filter() returns sum(w[i]*value[i])/divisor and
+	* returns the divisor. It may depend on the sampler's parameters and state, the focus and the frame
+	* times only, and samplers comparing equal under operator== must give the same weights; window_for_()
+	* relies on both to reuse a window cached for an equal copy of the sampler.
+	*/
+	template<class TIME_SAMPLER, typename TFOCUS, typename OTYPE>
+	struct weighted_ {
+		template<class U>
+		static auto test( int ) -> decltype( std::declval<const U&>().weights( std::declval<TFOCUS>(),
+		                                     std::declval<const std::vector<std::pair<time_type,iterator_type> >&>(),
+		                                     std::declval<std::vector<REAL>&>() ),
+		                                     std::declval<const U&>() == std::declval<const U&>(), std::true_type() );
+		template<class U>
+		static std::false_type test( ... );
+		static const bool value = decltype(test<TIME_SAMPLER>(0))::value && std::is_floating_point<OTYPE>::value
+		                          && std::is_copy_constructible<TIME_SAMPLER>::value;
+	};
+
+	/** \brief Samples attr at focus in every frame of the window around t and combines them in time
+	*/
+	template<class SAMPLER, class TIME_SAMPLER, typename TFOCUS, typename ... ADDITIONAL>
+	typename SAMPLER::OTYPE
+	sample_window_( const std::string& attr, const point_type& focus, TFOCUS t, SAMPLER& sampler,
+	                const TIME_SAMPLER& t_sampler, ADDITIONAL && ... additional ) {
+		return sample_window_( std::integral_constant<bool, weighted_<TIME_SAMPLER, TFOCUS, typename SAMPLER::OTYPE>::value>(),
+		                       attr, focus, t, sampler, t_sampler, additional... );
+	}
+
+	template<class SAMPLER, class TIME_SAMPLER, typename TFOCUS, typename ... ADDITIONAL>
+	typename SAMPLER::OTYPE
+	sample_window_( std::false_type, const std::string& attr, const point_type& focus, TFOCUS t, SAMPLER& sampler,
+	                const TIME_SAMPLER& t_sampler, ADDITIONAL && ... additional ) {
+		await_prediction_(attr, t, t_sampler, 0);
+
+		std::vector<std::pair<std::pair<time_type,iterator_type>,typename SAMPLER::OTYPE> > v;
+		const auto bounds = window_bounds_(t_sampler, t);
+		auto end = log.upper_bound(bounds.second);
+
+		if( log.size() == 1 ) end = log.end();
+
+		for( auto start = log.lower_bound(bounds.first); start != end; ++start ) {
+			const auto& iter = start->second.find(attr);
+			if( iter == start->second.end() ) continue;
+			v.emplace_back( start->first, sample_( iter->second, focus, sampler, additional... ) );
+		}
+
+		return t_sampler.filter(t, v);
+	}
+
+	template<class SAMPLER, class TIME_SAMPLER, typename TFOCUS, typename ... ADDITIONAL>
+	typename SAMPLER::OTYPE
+	sample_window_( std::true_type, const std::string& attr, const point_type& focus, TFOCUS t, SAMPLER& sampler,
+	                const TIME_SAMPLER& t_sampler, ADDITIONAL && ... additional ) {
+		using OTYPE = typename SAMPLER::OTYPE;
+		const std::shared_ptr<const window_> w = window_for_(attr, t, t_sampler);
+		OTYPE sum = OTYPE(0);
+		for( auto& f: w->frames ) sum += sample_( *f.first, focus, sampler, additional... ) * f.second;
+		return sum / w->divisor;
+	}
+
+	/** \brief Frames of attr in the window of t_sampler around t and their temporal weights,
+	* resolved once per log state and kept for the following fetches of the time step.
+	* Each attribute keeps its WINDOW_CACHE_SIZE most recently used windows.
+	*/
+	template<class TIME_SAMPLER, typename TFOCUS>
+	std::shared_ptr<const window_> window_for_( const std::string& attr, TFOCUS t, const TIME_SAMPLER& t_sampler ) {
+		const std::pair<time_type,iterator_type> key = window_key_(t);
+
+		{
+			std::lock_guard<std::mutex> lock(windows_mutex_);
+			std::shared_ptr<const window_> w = cached_window_(windows_[attr], key, t_sampler);
+			if( w ) return w;
+		}
+
+		// the barrier a prediction may wait in must not hold the cache, fetches of other threads use it
+		await_prediction_(attr, t, t_sampler, 0);
+
+		std::lock_guard<std::mutex> lock(windows_mutex_);
+		std::list<std::shared_ptr<const window_> >& cache = windows_[attr];
+		{
+			std::shared_ptr<const window_> w = cached_window_(cache, key, t_sampler);
+			if( w ) return w;
+		}
+
+		// entries of an older log can never match again
+		cache.remove_if([this](const std::shared_ptr<const window_>& w) { return w->version != log_version_; });
+		if( cache.size() >= WINDOW_CACHE_SIZE ) cache.pop_back();
+
+		std::shared_ptr<window_> w = std::make_shared<window_>();
+		w->version = log_version_;
+		w->focus = key;
+		w->sampler = &typeid(TIME_SAMPLER);
+		w->state = std::make_shared<const TIME_SAMPLER>(t_sampler);
+
+		std::vector<std::pair<time_type,iterator_type> > times;
+		std::vector<spatial_t*> frames;
+		window_frames_(attr, t, t_sampler, times, frames);
+
+		std::vector<REAL> weights;
+		w->divisor = t_sampler.weights(t, times, weights);
+		for( std::size_t i = 0; i < frames.size(); ++i )
+			if( weights[i] != REAL(0) ) w->frames.emplace_back(frames[i], weights[i]);
+
+		cache.push_front(w);
+		return w;
+	}
+
+	/** \brief Window of cache for an equal t_sampler at key and the current log moved to the front, else null
+	*/
+	template<class TIME_SAMPLER>
+	std::shared_ptr<const window_> cached_window_( std::list<std::shared_ptr<const window_> >& cache,
+	                                               const std::pair<time_type,iterator_type>& key, const TIME_SAMPLER& t_sampler ) {
+		for( auto itr = cache.begin(); itr != cache.end(); ++itr ) {
+			const window_& w = **itr;
+			if( w.version == log_version_ && w.focus == key && *w.sampler == typeid(TIME_SAMPLER) &&
+			    *static_cast<const TIME_SAMPLER*>(w.state.get()) == t_sampler ) {
+				cache.splice(cache.begin(), cache, itr);
+				return cache.front();
+			}
+		}
+		return nullptr;
+	}
+
+	/** \brief Times and frames of attr in the window of t_sampler around t
+	*/
+	template<class TIME_SAMPLER, typename TFOCUS>
+	void window_frames_( const std::string& attr, TFOCUS t, const TIME_SAMPLER& t_sampler,
+	                     std::vector<std::pair<time_type,iterator_type> >& times, std::vector<spatial_t*>& frames ) {
+		const auto bounds = window_bounds_(t_sampler, t);
+		auto end = log.upper_bound(bounds.second);
+
+		if( log.size() == 1 ) end = log.end();
+
+		for( auto start = log.lower_bound(bounds.first); start != end; ++start ) {
+			const auto& iter = start->second.find(attr);
+			if( iter == start->second.end() ) continue;
+			times.push_back(start->first);
+			frames.push_back(&iter->second);
+		}
+	}
+
+	/** \brief A PREDICTS sampler with too few committed frames of attr to extrapolate to t
+	* waits for the peers to reach t instead, and then interpolates
+	*/
+	template<class TIME_SAMPLER, typename TFOCUS>
+	auto await_prediction_( const std::string& attr, TFOCUS t, const TIME_SAMPLER& t_sampler, int )
+	-> typename std::enable_if<TIME_SAMPLER::PREDICTS>::type {
+		std::vector<std::pair<time_type,iterator_type> > times;
+		std::vector<spatial_t*> frames;
+		window_frames_(attr, t, t_sampler, times, frames);
+		if( !t_sampler.predictable(t, times) ) barrier_at_(t);
+	}
+
+	template<class TIME_SAMPLER, typename TFOCUS>
+	void await_prediction_( const std::string&, TFOCUS, const TIME_SAMPLER&, long ) {}
+
+	void barrier_at_( time_type t ) { barrier(t); }
+	void barrier_at_( std::pair<time_type,iterator_type> t ) { barrier(t.first, t.second); }
+
+	/** \brief One Smart Send round: msg reaches every remote rank and theirs are handled
+	*/
+	void exchange_ss_( message msg, bool sending ) {
+		if( !comm->collective() ) {
+			comm->send(std::move(msg));
+			if( sending ) barrier_ss_send();
+			else barrier_ss_recv();
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(mutex);
+		metrics::timer timer(&metrics_, metrics::BARRIER_SS);
+		for( auto& m: comm->exchange(std::move(msg)) ) readers[m.id()](std::move(m));
+		for( auto& p: peers ) {
+			if( sending ) p.set_ss_send_status(false);
+			else p.set_ss_recv_status(false);
+		}
+	}
+
+	/** \brief Records the time a peer has committed up to, part of a "commit" message
 	*/
 	void on_recv_confirm( int32_t sender, std::pair<time_type,iterator_type> timestamp ) {
 		peers[sender].set_current_t(timestamp.first);
 		peers[sender].set_current_sub(timestamp.second);
+		log_version_++;
+		barrier_update_(sender);
+	}
+
+	/** \brief Handles "commit" messages
+	* A commit travels as one message holding the fixed points, the (encoded) fixed-point
+	* frame, the (encoded) frame and the commit time; empty parts were not sent. Each part
+	* is handled by one of the helpers below.
+	*/
+	void on_recv_commit( int32_t sender, std::pair<time_type,iterator_type> timestamp, frame_pts_type points,
+	                     frame_raw_type raw, frame_transfer_type data, frame_codec_type craw, frame_codec_type cdata ) {
+		if( !points.empty() ) on_recv_points( sender, std::move(points) );
+		if( !craw.empty() ) on_recv_crawdata( sender, timestamp, std::move(craw) );
+		if( !raw.empty() ) on_recv_rawdata( sender, timestamp, std::move(raw) );
+		if( !cdata.empty() ) on_recv_cdata( sender, timestamp, std::move(cdata) );
+		if( !data.empty() ) on_recv_data( sender, timestamp, std::move(data) );
+		on_recv_confirm( sender, timestamp );
 	}
 
 	/** \brief Handles "forecast" messages
@@ -1128,37 +1617,248 @@ private:
 	void on_recv_forecast( int32_t sender, std::pair<time_type,iterator_type> timestamp ) {
 		peers[sender].set_next_t(timestamp.first);
 		peers[sender].set_next_sub(timestamp.second);
+		log_version_++;
+		barrier_update_(sender);
 	}
 
-	/** \brief Handles "data" messages
+	/** \brief Stores the frame of a "commit" message
+	* Values read off the wire arrive already split into point and value arrays,
+	* which the log entry takes over as they are.
 	*/
-	void on_recv_data( std::pair<time_type,iterator_type> timestamp, frame_type frame ) {
-		auto itr = log.find(timestamp);
+	void on_recv_data( int32_t sender, std::pair<time_type,iterator_type> timestamp, frame_transfer_type frame ) {
+		auto& cur = log_frame_(timestamp);
 
-		if( itr == log.end() )
-			std::tie(itr,std::ignore) = log.insert(std::make_pair(timestamp,bin_frame_type()));
+		for( auto& p: frame ){
+			auto pstr = cur.find(p.first);
+			if( pstr == cur.end() ) cur.insert(std::make_pair(p.first,spatial_t(sender,std::move(p.second),index_cache_for_(p.first))));
+			else pstr->second.insert(sender,std::move(p.second));
+		}
 
-		auto& cur = itr->second;
+		log.erase(log.begin(), log.upper_bound({timestamp.first-memory_length, timestamp.second}));
+		log_version_++;
+	}
+
+	/** \brief Stores the fixed-point frame of a "commit" message
+	* The values are stored as received and paired with the points the sender
+	* announced for each attribute, which are shared rather than copied.
+	*/
+	void on_recv_rawdata( int32_t sender, std::pair<time_type,iterator_type> timestamp, frame_raw_type frame ) {
+		auto& cur = log_frame_(timestamp);
 
 		for( auto& p: frame ){
+			points_ptr_t pts = peers[sender].pts(p.first);
+			if( !pts ) EXCEPTION(std::logic_error("MUI Error [uniface.h]: No fixed points received for attribute \"" + p.first + "\"."));
+
 			auto pstr = cur.find(p.first);
-			if( pstr == cur.end() ) cur.insert(std::make_pair(std::move(p.first),spatial_t(std::move(p.second))));
-			else pstr->second.insert(p.second);
+			if( pstr == cur.end() ) cur.insert(std::make_pair(p.first,spatial_t(sender,std::move(pts),std::move(p.second),index_cache_for_(p.first))));
+			else pstr->second.insert(sender,std::move(pts),std::move(p.second));
 		}
 
 		log.erase(log.begin(), log.upper_bound({timestamp.first-memory_length, timestamp.second}));
+		log_version_++;
 	}
 
-	/** \brief Handles "data" messages
+	/** \brief Decodes and stores the encoded frame of a "commit" message
 	*/
-	void on_recv_rawdata( int32_t sender, std::pair<time_type,iterator_type> timestamp, frame_raw_type frame ) {
-		on_recv_data( timestamp, associate( sender, frame ) );
+	void on_recv_cdata( int32_t sender, std::pair<time_type,iterator_type> timestamp, frame_codec_type frame ) {
+		frame_transfer_type buf;
+		for( auto& p: frame ) buf.emplace(p.first, typename spatial_t::transfer_type(peers[sender].decoder().template decode<storage_t>(p.first, p.second)));
+		on_recv_data( sender, timestamp, std::move(buf) );
+	}
+
+	/** \brief Decodes and stores the encoded fixed-point frame of a "commit" message
+	*/
+	void on_recv_crawdata( int32_t sender, std::pair<time_type,iterator_type> timestamp, frame_codec_type frame ) {
+		frame_raw_type buf;
+		for( auto& p: frame ) buf.emplace(p.first, peers[sender].decoder().template decode<storage_raw_t>(p.first, p.second));
+		on_recv_rawdata( sender, timestamp, std::move(buf) );
+	}
+
+	bool codec_enabled_() const {
+		return default_codec_ || !codecs_.empty();
+	}
+
+	/** \brief Encodes every attribute of a frame with its codec
+	* Delta references restart whenever the set of destinations changes, so that
+	* every receiver always holds the frame a delta was taken against.
+	*/
+	template<typename FRAME>
+	frame_codec_type encode_frame_( const FRAME& frame, const std::vector<bool>& dest ) {
+		if( codec_peers_ != dest ) {
+			codec_.reset();
+			codec_peers_ = dest;
+		}
+
+		static const codec_config plain(false, false, codec_compression::none);
+		frame_codec_type buf;
+		for( auto& p: frame ) {
+			auto itr = codecs_.find(p.first);
+			const codec_config& config = itr != codecs_.end() ? itr->second : default_codec_ ? *default_codec_ : plain;
+			buf.emplace(p.first, codec_.encode(p.first, p.second, config));
+		}
+		return buf;
+	}
+
+	/** \brief Takes the pushed data of a commit off the push buffers
+	*/
+	void prepare_commit_( commit_job_& job, time_type t, iterator_type it ) {
+		job.time = std::make_pair(t, it);
+
+		// Check Smart Send if announcement made
+		if ( !smart_send_set_ ) {
+			// Reset all peers to default of enabled
+			std::fill(peer_is_sending.begin(), peer_is_sending.end(), true);
+			update_smart_send(t);
+			smart_send_set_ = true;
+		}
+		job.dest = peer_is_sending;
+
+		if( FIXEDPOINTS ) {
+			// This only happens during the first commit
+			if( push_buffer_pts.size() > 0 ) {
+				job.pts.swap(push_buffer_pts);
+				initialized_pts_ = true;
+			}
+			job.raw.swap(push_buffer_raw);
+		}
+		else job.data.swap(push_buffer);
+
+		for( auto& p: job.pts ) job.bytes += p.second.size()*sizeof(point_type);
+		for( auto& p: job.raw ) job.bytes += p.second.apply_visitor(bytes_());
+		for( auto& p: job.data ) job.bytes += p.second.apply_visitor(bytes_());
+	}
+
+	/** \brief Serializes a commit into one message per peer
+	*/
+	void pack_commit_( commit_job_& job ) {
+		metrics::timer timer(&metrics_, metrics::SERIALISE);
+		frame_codec_type craw, cdata;
+		if( codec_enabled_() ) {
+			if( job.raw.size() > 0 ) craw = encode_frame_(job.raw, job.dest);
+			if( job.data.size() > 0 ) cdata = encode_frame_(job.data, job.dest);
+			frame_raw_type().swap(job.raw);
+			frame_type().swap(job.data);
+		}
+
+		frame_transfer_type data;
+		for( auto& p: job.data ) data.emplace(p.first, typename spatial_t::transfer_type(std::move(p.second)));
+
+		job.msgs.emplace_back( make_message_("commit",comm->local_rank(),job.time,std::move(job.pts),std::move(job.raw),
+		                                     std::move(data),std::move(craw),std::move(cdata)) );
+
+		frame_pts_type().swap(job.pts);
+		frame_raw_type().swap(job.raw);
+		frame_type().swap(job.data);
+	}
+
+	/** \brief Builds a message, left unserialised for in-process communicators
+	*/
+	template<typename... types>
+	message make_message_( const message::id_type& id, types&&... data ) {
+		if( comm->in_process() ) return message::make_lazy(id, std::forward<types>(data)...);
+		return message::make(id, std::forward<types>(data)...);
+	}
+
+	void send_commit_( commit_job_& job ) {
+		for( auto& m: job.msgs ) comm->send( std::move(m), job.dest );
+		std::vector<message>().swap(job.msgs);
+	}
+
+	/** \brief Marks an asynchronous commit sent, async_mutex_ must be held
+	*/
+	void release_commit_( commit_job_& job ) {
+		auto itr = std::find_if(async_jobs_.begin(), async_jobs_.end(),
+		                        [&](const std::shared_ptr<commit_job_>& j) { return j.get() == &job; });
+		if( itr != async_jobs_.end() ) async_jobs_.erase(itr);
+		async_bytes_ -= job.bytes;
+		job.sent = true;
+		async_cv_.notify_all();
+	}
+
+	/** \brief Body of the background thread of async_commit()
+	*/
+	void async_work_() {
+		std::unique_lock<std::mutex> lock(async_mutex_);
+		for(;;) {
+			async_cv_.wait(lock, [this]() { return async_stop_ || !async_pack_.empty(); });
+			if( async_pack_.empty() ) return;
+
+			std::shared_ptr<commit_job_> job = async_pack_.front();
+			async_pack_.pop_front();
+			lock.unlock();
+
+			std::exception_ptr error;
+			try {
+				pack_commit_( *job );
+				if( async_concurrent_ ) send_commit_( *job );
+			}
+			catch( ... ) {
+				error = std::current_exception();
+			}
+
+			lock.lock();
+			job->packed = true;
+			if( error && !async_error_ ) async_error_ = error;
+			if( async_concurrent_ || error ) release_commit_( *job );
+			async_cv_.notify_all();
+		}
+	}
+
+	/** \brief Sends packed asynchronous commits in order
+	* With block set, waits until until (or every queued commit) has been sent.
+	* Rethrows the first failure of the background thread.
+	*/
+	void flush_commits_( bool block, const commit_job_* until = nullptr ) {
+		std::unique_lock<std::mutex> lock(async_mutex_);
+		for(;;) {
+			if( async_error_ ) {
+				std::exception_ptr error = async_error_;
+				async_error_ = nullptr;
+				std::rethrow_exception(error);
+			}
+			if( async_jobs_.empty() || (until && until->sent) ) return;
+
+			std::shared_ptr<commit_job_> job = async_jobs_.front();
+			if( job->packed && !async_concurrent_ ) {
+				lock.unlock();
+				send_commit_( *job );
+				lock.lock();
+				release_commit_( *job );
+			}
+			else if( block ) async_cv_.wait(lock);
+			else return;
+		}
+	}
+
+	void drain_commits_() {
+		if( async_worker_.joinable() ) flush_commits_( true );
+	}
+
+	/** \brief Returns the log frame at timestamp, creating it if needed
+	*/
+	bin_frame_type& log_frame_( std::pair<time_type,iterator_type> timestamp ) {
+		log_version_++;
+		auto itr = log.find(timestamp);
+
+		if( itr == log.end() )
+			std::tie(itr,std::ignore) = log.insert(std::make_pair(timestamp,bin_frame_type()));
+
+		return itr->second;
+	}
+
+	/** \brief Returns the spatial index cache of attribute attr
+	*/
+	std::shared_ptr<index_cache_t> index_cache_for_( const std::string& attr ) {
+		std::shared_ptr<index_cache_t>& cache = index_cache_[attr];
+		if( !cache ) cache = std::make_shared<index_cache_t>();
+		return cache;
 	}
 
 	/** \brief Handles "receivingSpan" messages
 	*/
 	void on_recv_span( int32_t sender, time_type start, time_type timeout, span_t s ) {
 		peers[sender].set_recving(start,timeout,std::move(s));
+		recv_index_dirty_ = true;
 		peers[sender].set_ss_recv_status(true);
 	}
 
@@ -1167,6 +1867,7 @@ private:
 	void on_send_span( int32_t sender, time_type start, time_type timeout, span_t s ) {
 		peers[sender].set_sending(start,timeout,std::move(s));
 		peers[sender].set_ss_send_status(true);
+		barrier_update_(sender);
 	}
 
 	/** \brief Handles "sendingDisable" messages
@@ -1175,6 +1876,7 @@ private:
 		peers[sender].set_recv_disable();
 		peers[sender].set_ss_recv_status(true);
 		peer_is_sending[sender] = false;
+		recv_index_dirty_ = true;
 	}
 
 	/** \brief Handles "receivingDisable" messages
@@ -1182,11 +1884,12 @@ private:
 	void on_send_disable( int32_t sender ) {
 		peers[sender].set_send_disable();
 		peers[sender].set_ss_send_status(true);
+		barrier_update_(sender);
 	}
 
-	/** \brief Handles "points" messages
+	/** \brief Keeps the fixed points announced in a "commit" message
 	*/
-	void on_recv_points( int32_t sender, std::vector<point_type> points ) {
+	void on_recv_points( int32_t sender, frame_pts_type points ) {
 		peers[sender].set_pts(points);
 	}
 
@@ -1199,29 +1902,6 @@ private:
 		else 
 			assigned_values.insert( std::pair<std::string, storage_single_t>( attr, data ) );
 	}
-
-	/** \brief Associates raw data and stored point data together
-	*/
-	inline frame_type associate( int32_t sender, frame_raw_type& frame ) {
-		frame_type buf;
-		const auto& pts = peers[sender].pts();
-
-		for( auto& p: frame ) {
-			const auto& data = storage_cast<const std::vector<std::pair<size_t,REAL> >&>(p.second);
-
-			buf.insert(std::make_pair(p.first, storage_t(std::vector<std::pair<point_type,REAL> >())));
-			std::vector<std::pair<point_type,REAL> >& data_store = storage_cast<std::vector<std::pair<point_type,REAL> >&>(buf[p.first]);
-
-		    data_store.resize(data.size());
-
-			for( size_t i=0; i<data.size(); i++ ) {
-				data_store[i].first = pts[data[i].first];
-				data_store[i].second = data[i].second;
-			}
-		}
-
-		return buf;
-	}
 };
 
 }